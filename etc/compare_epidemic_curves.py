@@ -0,0 +1,109 @@
+#!/usr/bin/env python
+
+import argparse
+import re
+import sys
+
+import numpy as np
+
+def get_args() -> argparse.Namespace:
+    '''
+    Get command line arguments
+
+    We need two sets of log files (the standard output of the agent
+    executable), one from the reference build and one from the build
+    being validated, each run with several different values of agent.seed.
+    '''
+    describe = '''
+This tool compares the epidemic curves printed by two sets of runs, for
+example a build with double precision agent attributes and a build with
+-DAMReX_PARTICLES_PRECISION=SINGLE. For each day and each compartment, the
+difference of the mean over the runs of the two sets is compared to its
+standard error estimated from the spread of the runs. The two builds agree
+within stochastic noise if no difference exceeds the given number of
+standard errors.'''
+    parser = argparse.ArgumentParser(description=describe)
+    parser.add_argument("--reference", nargs="+", required=True,
+                        help="log files of the reference runs")
+    parser.add_argument("--test", nargs="+", required=True,
+                        help="log files of the runs to validate")
+    parser.add_argument("--nsigma", type=float, default=4.0,
+                        help="maximum difference of the means, in standard errors")
+    parser.add_argument("--csv", help="write the mean curves and their differences to this file")
+    return parser.parse_args()
+
+compartments = ["never", "infected", "immune", "deaths"]
+
+def read_curves(filename: str) -> np.ndarray:
+    '''
+    Extract the totals printed for each simulated day from a log file,
+    and return them as an array of shape (days, compartments). With
+    agent.async_diagnostics, the totals of each day follow a "Totals of
+    day <n>:" line, printed during the next day.
+    '''
+    pattern = re.compile(r"^\s*Total (\w+): (\d+)")
+    delayed = re.compile(r"^\s*Totals of day (\d+):")
+    days = []
+    day = None
+    with open(filename) as fp:
+        for line in fp:
+            if line.startswith("Simulating day"):
+                days.append({})
+                day = len(days) - 1
+                continue
+            m = delayed.match(line)
+            if m:
+                day = int(m.group(1))
+                continue
+            m = pattern.match(line)
+            if m and day is not None and day < len(days) and m.group(1) in compartments:
+                days[day][m.group(1)] = int(m.group(2))
+    days = [d for d in days if len(d) == len(compartments)]
+    return np.array([[d[c] for c in compartments] for d in days], dtype=float)
+
+def read_ensemble(filenames: list) -> np.ndarray:
+    '''
+    Read the curves of a set of runs, truncated to the shortest run,
+    and return them as an array of shape (runs, days, compartments).
+    '''
+    curves = [read_curves(f) for f in filenames]
+    ndays = min(len(c) for c in curves)
+    if ndays == 0:
+        sys.exit("error: no daily totals found in the log files")
+    return np.array([c[:ndays] for c in curves])
+
+def main() -> None:
+    args = get_args()
+    ref = read_ensemble(args.reference)
+    test = read_ensemble(args.test)
+    ndays = min(ref.shape[1], test.shape[1])
+    ref, test = ref[:, :ndays], test[:, :ndays]
+
+    mean_ref, mean_test = ref.mean(axis=0), test.mean(axis=0)
+    var_ref = ref.var(axis=0, ddof=1) if len(ref) > 1 else np.zeros_like(mean_ref)
+    var_test = test.var(axis=0, ddof=1) if len(test) > 1 else np.zeros_like(mean_test)
+    # standard error of the difference of the means, at least one agent
+    stderr = np.maximum(np.sqrt(var_ref/len(ref) + var_test/len(test)), 1.0)
+    zscore = np.abs(mean_test - mean_ref)/stderr
+
+    for k, c in enumerate(compartments):
+        day = int(np.argmax(zscore[:, k]))
+        print(f"{c:>9s}: max difference {zscore[day, k]:.2f} standard errors on day {day} "
+              f"(reference {mean_ref[day, k]:.1f}, test {mean_test[day, k]:.1f})")
+
+    if args.csv:
+        with open(args.csv, 'w') as fp:
+            fp.write("day," + ",".join(f"{c}_reference,{c}_test,{c}_zscore" for c in compartments) + "\n")
+            for day in range(ndays):
+                fp.write(f"{day}," + ",".join(f"{mean_ref[day, k]},{mean_test[day, k]},{zscore[day, k]}"
+                                              for k in range(len(compartments))) + "\n")
+
+    if len(ref) < 2 or len(test) < 2:
+        print("warning: at least two runs per set are needed to estimate the stochastic noise")
+    if np.max(zscore) > args.nsigma:
+        print(f"FAIL: the curves differ by more than {args.nsigma} standard errors")
+        sys.exit(1)
+    print(f"PASS: the curves agree within {args.nsigma} standard errors")
+
+if __name__ == "__main__":
+    main()
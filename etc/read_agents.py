@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+
+import argparse
+import os
+import sys
+
+import numpy as np
+
+def get_args() -> argparse.Namespace:
+    '''
+    Get command line arguments
+    '''
+    describe = '''
+This tool reads the agents written to a plot file (plt*/agents), with the
+attributes and the subsample of agents selected by agent.plot_real_attribs,
+agent.plot_int_attribs and agent.plot_agent_stride, and prints a summary or
+writes them to a CSV file.'''
+    parser = argparse.ArgumentParser(description=describe)
+    parser.add_argument("plotfile", help="plot file directory, e.g. plt00010")
+    parser.add_argument("--name", default="agents", help="name of the particles in the plot file")
+    parser.add_argument("--csv", help="write the agents to this file")
+    return parser.parse_args()
+
+def read_agents(plotfile: str, name: str = "agents") -> dict:
+    '''
+    Read the agents of a plot file in the AMReX particle format, and return a
+    dictionary of arrays with one entry per agent: "id", "cpu", the
+    positions "x", "y" (and "z"), and the attributes written.
+    '''
+    pdir = os.path.join(plotfile, name)
+    with open(os.path.join(pdir, "Header")) as fp:
+        lines = iter(fp.read().split("\n"))
+        version = next(lines).strip()
+        dim = int(next(lines))
+        real_names = [next(lines).strip() for _ in range(int(next(lines)))]
+        int_names = [next(lines).strip() for _ in range(int(next(lines)))]
+        next(lines)  # is_checkpoint
+        next(lines)  # number of particles
+        next(lines)  # next id
+        finest_level = int(next(lines))
+        ngrids = [int(next(lines)) for _ in range(finest_level + 1)]
+        grids = [[tuple(int(v) for v in next(lines).split()) for _ in range(n)] for n in ngrids]
+
+    real_type = np.float64 if version.endswith("_double") else np.float32
+    # since version 2.1, the id and cpu of each particle are packed into a 64-bit integer
+    packed_idcpu = "Two_Dot_One" in version
+    pos_names = ["x", "y", "z"][:dim]
+
+    chunks = []
+    for lev, level_grids in enumerate(grids):
+        for which, count, offset in level_grids:
+            if count == 0:
+                continue
+            fn = os.path.join(pdir, f"Level_{lev}", f"DATA_{which:05d}")
+            with open(fn, "rb") as fp:
+                fp.seek(offset)
+                chunk = {}
+                if packed_idcpu:
+                    idcpu = np.fromfile(fp, dtype=np.uint64, count=count)
+                    ints = np.fromfile(fp, dtype=np.int32, count=count*len(int_names))
+                    ints = ints.reshape(count, len(int_names))
+                    chunk["id"] = (idcpu >> np.uint64(24)).astype(np.int64) - (1 << 39)
+                    chunk["cpu"] = (idcpu & np.uint64(0xFFFFFF)).astype(np.int64)
+                else:
+                    ints = np.fromfile(fp, dtype=np.int32, count=count*(2 + len(int_names)))
+                    ints = ints.reshape(count, 2 + len(int_names))
+                    chunk["id"], chunk["cpu"] = ints[:, 0], ints[:, 1]
+                    ints = ints[:, 2:]
+                reals = np.fromfile(fp, dtype=real_type, count=count*(dim + len(real_names)))
+                reals = reals.reshape(count, dim + len(real_names))
+            for k, n in enumerate(pos_names + real_names):
+                chunk[n] = reals[:, k]
+            for k, n in enumerate(int_names):
+                chunk[n] = ints[:, k]
+            chunks.append(chunk)
+
+    names = ["id", "cpu"] + pos_names + real_names + int_names
+    if not chunks:
+        return {n: np.empty(0) for n in names}
+    return {n: np.concatenate([c[n] for c in chunks]) for n in names}
+
+def main() -> None:
+    args = get_args()
+    agents = read_agents(args.plotfile, args.name)
+    print(f"{len(agents['id'])} agents, attributes: {', '.join(agents.keys())}")
+    if "status" in agents:
+        counts = np.bincount(agents["status"].astype(np.int64), minlength=5)
+        print("agents by status (never, infected, immune, susceptible, dead):", counts.tolist())
+
+    if args.csv:
+        names = list(agents.keys())
+        np.savetxt(args.csv, np.column_stack([agents[n] for n in names]),
+                   delimiter=",", header=",".join(names), comments="", fmt="%.17g")
+
+if __name__ == "__main__":
+    sys.exit(main())
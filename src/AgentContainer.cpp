@@ -4,6 +4,17 @@
 
 #include "AgentContainer.H"
 
+#include <AMReX_OpenMP.H>
+
+#ifdef AMREX_USE_OMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <set>
+
 using namespace amrex;
 
 namespace {
@@ -156,6 +167,937 @@ namespace {
         ParallelDescriptor::Bcast(&cell_indices[0], cell_indices.size(),
                                   ParallelDescriptor::IOProcessorNumber());
     }
+
+    /*! \brief Agent attributes read by the interaction kernels */
+    struct AgentAttribs
+    {
+        IntAttrib<IntIdx::status>::ptr_type status; /*!< see #IntIdx::status */
+        IntAttrib<IntIdx::age_group>::ptr_type age_group; /*!< see #IntIdx::age_group */
+        IntAttrib<IntIdx::family>::ptr_type family; /*!< see #IntIdx::family */
+        IntAttrib<IntIdx::nborhood>::ptr_type nborhood; /*!< see #IntIdx::nborhood */
+        IntAttrib<IntIdx::school>::ptr_type school; /*!< see #IntIdx::school */
+        IntAttrib<IntIdx::withdrawn>::ptr_type withdrawn; /*!< see #IntIdx::withdrawn */
+        IntAttrib<IntIdx::workgroup>::ptr_type workgroup; /*!< see #IntIdx::workgroup */
+        IntAttrib<IntIdx::work_i>::ptr_type work_i; /*!< see #IntIdx::work_i */
+        const ParticleReal* counter;    /*!< see #RealIdx::disease_counter */
+        const ParticleReal* incubation_period; /*!< see #RealIdx::incubation_period */
+
+        /*! \brief Is agent j infected and past the incubation stage? */
+        AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+        bool infectious (unsigned int j) const noexcept
+        {
+            return (status[j] == Status::infected) && (counter[j] >= incubation_period[j]);
+        }
+    };
+
+    /*! \brief Attributes of the work proxies received by a rank, read by interact_pairwise()
+        at work in place of #AgentAttribs (see AgentContainer::interactWorkProxies()) */
+    struct ProxyAttribs
+    {
+        PackedIntPtr<ProxyField::status> status;        /*!< see #IntIdx::status */
+        PackedIntPtr<ProxyField::age_group> age_group;  /*!< see #IntIdx::age_group */
+        PackedIntPtr<ProxyField::nborhood> nborhood;    /*!< see #IntIdx::nborhood */
+        PackedIntPtr<ProxyField::school> school;        /*!< see #IntIdx::school */
+        PackedIntPtr<ProxyField::withdrawn> withdrawn;  /*!< see #IntIdx::withdrawn */
+        PackedIntPtr<ProxyField::infectious> infectious_flag; /*!< see #ProxyField */
+        const int* workgroup;                           /*!< see #IntIdx::workgroup */
+        const int* work_i;                              /*!< work community (always >= 0) */
+
+        /*! \brief Is proxy j infected and past the incubation stage? */
+        AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+        bool infectious (unsigned int j) const noexcept { return infectious_flag[j]; }
+    };
+
+    /*! \brief Pairwise interactions of agent i with the other agents of its community
+        [cell_start, cell_stop), at work (DAYTIME) or at home
+
+        Uses the contact coefficient tables of #DiseaseParm, so that the transmission
+        probability of a pair does not branch on the age group and school of the agents; the
+        terms that cannot apply in a phase (family and neighborhood cluster at work, workgroup
+        and school at home) are compiled out. See AgentContainer::interactAgentsHomeWork().
+        The attributes are read from #AgentAttribs, or at work from #ProxyAttribs.
+    */
+    template <bool DAYTIME, typename Attribs>
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    void interact_pairwise (unsigned int i, const unsigned int* inds,
+                            unsigned int cell_start, unsigned int cell_stop,
+                            Attribs const& a, const DiseaseParm* lparm,
+                            ParticleReal* prob_ptr, bool log_prob) noexcept
+    {
+        if ( a.status[i] != Status::never &&
+             a.status[i] != Status::susceptible ) { return; }
+
+        const int age = a.age_group[i];
+        const int school = a.school[i];
+        const bool i_out = !a.withdrawn[i];
+        const bool i_at_work = DAYTIME && a.workgroup[i] && (a.work_i[i] >= 0);
+
+        amrex::Real infect = lparm->infect;
+        infect *= lparm->vac_eff;
+
+        amrex::Real social_scale = 1.0;  // TODO this should vary based on cell
+        amrex::Real work_scale = 1.0;  // TODO this should vary based on cell
+
+        const auto& table = lparm->xmit_table;
+        const auto& school_table = lparm->xmit_school_table[(school > 6) ? 6 : ((school < 0) ? 0 : school)];
+
+        amrex::Real log_escape = 0.0;
+        for (unsigned int jj = cell_start; jj < cell_stop; ++jj) {
+            auto j = inds[jj];
+            if (!a.infectious(j)) { continue; }  // not infected, or incubation stage
+
+            const int c = xmit_class(a.age_group[j], a.school[j]);
+            const bool same_hood = (a.nborhood[i] == a.nborhood[j]);
+
+            amrex::Real prob = 1.0;
+            if constexpr (!DAYTIME) {
+                if (same_hood && (a.family[i] == a.family[j])) {
+                    prob *= 1.0 - infect * table[XmitSetting::family][c][age];
+                } else if (same_hood && i_out && (!a.withdrawn[j]) && ((a.family[i] / 4) == (a.family[j] / 4))) {
+                    prob *= 1.0 - infect * table[XmitSetting::nc][c][age] * social_scale;
+                }
+            }
+
+            /* Home isolation or household quarantine? */
+            if (i_out && (!a.withdrawn[j])) {
+                prob *= 1.0 - infect * table[XmitSetting::comm][c][age] * social_scale;
+
+                if (DAYTIME && i_at_work && (a.workgroup[i] == a.workgroup[j]) && (a.work_i[j] >= 0)) {
+                    prob *= 1.0 - infect * table[XmitSetting::work][c][age] * work_scale;
+                }
+
+                if (same_hood) {
+                    prob *= 1.0 - infect * table[XmitSetting::hood][c][age] * social_scale;
+                    if (DAYTIME && (school >= 5) && (school == a.school[j])) {  // daycare or playgroup
+                        prob *= 1.0 - infect * school_table[c][age] * social_scale;
+                    }
+                }
+
+                if (DAYTIME && (school > 0) && (school < 5) && (school == a.school[j])) {
+                    prob *= 1.0 - infect * school_table[c][age] * social_scale;
+                }
+            }
+
+            if (log_prob) {
+                log_escape += std::log(prob);
+            } else {
+                prob_ptr[i] *= static_cast<ParticleReal>(prob);
+            }
+        }
+        if (log_prob) { prob_ptr[i] += static_cast<ParticleReal>(log_escape); }
+    }
+
+    /*! \brief Contiguous copies of the attributes of the infectious agents of one community,
+        read by the vectorized CPU interaction kernel (see interact_pairwise_simd()) */
+    struct CommunityScratch
+    {
+        Vector<int> xclass;             /*!< transmitter class (#XmitClass) */
+        Vector<int> nborhood;           /*!< see #IntIdx::nborhood */
+        Vector<int> family;             /*!< see #IntIdx::family */
+        Vector<int> out;                /*!< not withdrawn? */
+        Vector<int> workgroup;          /*!< see #IntIdx::workgroup */
+        Vector<int> at_work;            /*!< work_i >= 0? */
+        Vector<int> school;             /*!< see #IntIdx::school */
+        Vector<Real> escape;            /*!< probability of not being infected by each agent */
+
+        void resize (int n)
+        {
+            xclass.resize(n); nborhood.resize(n); family.resize(n); out.resize(n);
+            workgroup.resize(n); at_work.resize(n); school.resize(n); escape.resize(n);
+        }
+    };
+
+    /*! \brief CPU version of interact_pairwise() over all the communities of a tile
+
+        The attributes of the infectious agents of each community are first gathered into
+        contiguous arrays, so that, for each receiver, the transmission probabilities from all
+        the infectious agents of its community are computed in a vectorized (SIMD) loop without
+        any branch or indirect access. The cost per community is then the number of susceptible
+        agents times the number of infectious agents, instead of the square of its size. The
+        probabilities are multiplied (or their logarithms added) in the same order as in
+        interact_pairwise(), which gives the same result.
+    */
+    template <bool DAYTIME>
+    void interact_pairwise_simd (const unsigned int* inds, const unsigned int* offsets, int ncells,
+                                 AgentAttribs const& a, const DiseaseParm* lparm,
+                                 ParticleReal* prob_ptr, bool log_prob)
+    {
+        CommunityScratch g;
+
+        amrex::Real infect = lparm->infect;
+        infect *= lparm->vac_eff;
+
+        amrex::Real social_scale = 1.0;  // TODO this should vary based on cell
+        amrex::Real work_scale = 1.0;  // TODO this should vary based on cell
+
+        for (int cell = 0; cell < ncells; ++cell) {
+            const unsigned int start = offsets[cell];
+            const int n = static_cast<int>(offsets[cell+1] - start);
+            if (n == 0) { continue; }
+
+            // gather the infectious agents (past the incubation stage) of the community
+            g.resize(n);
+            int nt = 0;
+            for (int k = 0; k < n; ++k) {
+                auto j = inds[start+k];
+                if ( (a.status[j] != Status::infected) || (a.counter[j] < a.incubation_period[j]) ) { continue; }
+                g.xclass[nt] = xmit_class(a.age_group[j], a.school[j]);
+                g.nborhood[nt] = a.nborhood[j];
+                g.family[nt] = a.family[j];
+                g.out[nt] = !a.withdrawn[j];
+                g.workgroup[nt] = a.workgroup[j];
+                g.at_work[nt] = (a.work_i[j] >= 0);
+                g.school[nt] = a.school[j];
+                ++nt;
+            }
+            if (nt == 0) { continue; }
+
+            const int* AMREX_RESTRICT p_xclass = g.xclass.data();
+            const int* AMREX_RESTRICT p_nborhood = g.nborhood.data();
+            const int* AMREX_RESTRICT p_family = g.family.data();
+            const int* AMREX_RESTRICT p_out = g.out.data();
+            const int* AMREX_RESTRICT p_workgroup = g.workgroup.data();
+            const int* AMREX_RESTRICT p_at_work = g.at_work.data();
+            const int* AMREX_RESTRICT p_school = g.school.data();
+            Real* AMREX_RESTRICT p_escape = g.escape.data();
+
+            for (int k_i = 0; k_i < n; ++k_i) {
+                auto i = inds[start+k_i];
+                if ( a.status[i] != Status::never &&
+                     a.status[i] != Status::susceptible ) { continue; }
+
+                const int age = a.age_group[i];
+                const int school = a.school[i];
+                const int nborhood = a.nborhood[i];
+                const int family = a.family[i];
+                const int workgroup = a.workgroup[i];
+                const bool i_out = !a.withdrawn[i];
+                const bool i_at_work = DAYTIME && workgroup && (a.work_i[i] >= 0);
+                const bool in_school = DAYTIME && (school > 0) && (school < 5);
+                const bool in_daycare = DAYTIME && (school >= 5);
+
+                /* probability of not being infected in each setting, by transmitter class */
+                const auto& table = lparm->xmit_table;
+                const auto& school_table = lparm->xmit_school_table[(school > 6) ? 6 : ((school < 0) ? 0 : school)];
+                Real e_family[XmitClass::nclasses], e_nc[XmitClass::nclasses],
+                     e_comm[XmitClass::nclasses], e_hood[XmitClass::nclasses],
+                     e_work[XmitClass::nclasses], e_school[XmitClass::nclasses];
+                for (int c = 0; c < XmitClass::nclasses; ++c) {
+                    e_family[c] = 1.0 - infect * table[XmitSetting::family][c][age];
+                    e_nc[c] = 1.0 - infect * table[XmitSetting::nc][c][age] * social_scale;
+                    e_comm[c] = 1.0 - infect * table[XmitSetting::comm][c][age] * social_scale;
+                    e_hood[c] = 1.0 - infect * table[XmitSetting::hood][c][age] * social_scale;
+                    e_work[c] = 1.0 - infect * table[XmitSetting::work][c][age] * work_scale;
+                    e_school[c] = 1.0 - infect * school_table[c][age] * social_scale;
+                }
+
+                AMREX_PRAGMA_SIMD
+                for (int k = 0; k < nt; ++k) {
+                    const int c = p_xclass[k];
+                    const bool same_hood = (p_nborhood[k] == nborhood);
+                    const bool out = i_out && p_out[k];
+
+                    Real prob = 1.0;
+                    if (!DAYTIME) {
+                        const bool same_family = same_hood && (p_family[k] == family);
+                        const bool same_nc = same_hood && (!same_family) && out && ((p_family[k] / 4) == (family / 4));
+                        prob *= same_family ? e_family[c] : 1.0;
+                        prob *= same_nc ? e_nc[c] : 1.0;
+                    }
+                    prob *= out ? e_comm[c] : 1.0;
+                    if (DAYTIME) {
+                        prob *= (out && i_at_work && (p_workgroup[k] == workgroup) && p_at_work[k]) ? e_work[c] : 1.0;
+                    }
+                    prob *= (out && same_hood) ? e_hood[c] : 1.0;
+                    if (DAYTIME) {
+                        const bool same_school = out && (p_school[k] == school);
+                        prob *= (same_school && same_hood && in_daycare) ? e_school[c] : 1.0;
+                        prob *= (same_school && in_school) ? e_school[c] : 1.0;
+                    }
+                    p_escape[k] = prob;
+                }
+
+                if (log_prob) {
+                    amrex::Real log_escape = 0.0;
+                    for (int k = 0; k < nt; ++k) { log_escape += std::log(p_escape[k]); }
+                    prob_ptr[i] += static_cast<ParticleReal>(log_escape);
+                } else {
+                    for (int k = 0; k < nt; ++k) { prob_ptr[i] *= static_cast<ParticleReal>(p_escape[k]); }
+                }
+            }
+        }
+    }
+
+    /*! \brief Records the time spent on a tile as its cost, and adds it to the busy time of
+        the calling thread (see AgentContainer::tileSchedule()) */
+    struct TileTimer
+    {
+        Real& cost;                         /*!< cost of the tile */
+        Vector<Real>& busy;                 /*!< busy time of each thread */
+        double start = amrex::second();
+
+        ~TileTimer ()
+        {
+            auto dt = static_cast<Real>(amrex::second() - start);
+            cost = dt;
+            busy[OpenMP::get_thread_num()] += dt;
+        }
+    };
+
+    /*! \brief Sets the OpenMP run-time schedule of the tile loops of a phase (see
+        AgentContainer::tileSchedule()), and restores the previous one when it goes out of scope */
+    struct TileLoopSchedule
+    {
+        explicit TileLoopSchedule (bool dynamic) noexcept
+        {
+#ifdef AMREX_USE_OMP
+            omp_get_schedule(&kind, &chunk);
+            omp_set_schedule(dynamic ? omp_sched_dynamic : omp_sched_static, dynamic ? 1 : 0);
+#else
+            amrex::ignore_unused(dynamic);
+#endif
+        }
+
+        ~TileLoopSchedule ()
+        {
+#ifdef AMREX_USE_OMP
+            omp_set_schedule(kind, chunk);
+#endif
+        }
+
+        TileLoopSchedule (TileLoopSchedule const&) = delete;
+        TileLoopSchedule& operator= (TileLoopSchedule const&) = delete;
+
+#ifdef AMREX_USE_OMP
+        omp_sched_t kind;       /*!< previous schedule kind */
+        int chunk;              /*!< previous chunk size */
+#endif
+    };
+
+    /*! \brief Random event of probability \p p, drawing a random number only if \p p is
+        positive (see AgentContainer::updateStatus()) */
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    bool random_event (Real p, AgentRNG& rng) noexcept
+    {
+        return (p > 0.0_rt) && (rng.uniform() < p);
+    }
+
+    /*! \brief Disease attributes of the agents of a tile, and the daily updates applied to them
+        (see AgentContainer::updateStatus(), AgentContainer::infectAgents() and
+        AgentContainer::dailyUpdate())
+    */
+    struct DiseaseState
+    {
+        IntAttrib<IntIdx::status>::ptr_type status;         /*!< see #IntIdx::status */
+        IntAttrib<IntIdx::age_group>::ptr_type age_group;   /*!< see #IntIdx::age_group */
+        IntAttrib<IntIdx::home_i>::ptr_type home_i;         /*!< see #IntIdx::home_i */
+        IntAttrib<IntIdx::home_j>::ptr_type home_j;         /*!< see #IntIdx::home_j */
+        IntAttrib<IntIdx::event_day>::ptr_type event_day;   /*!< see #IntIdx::event_day */
+        ParticleReal* counter;              /*!< see #RealIdx::disease_counter */
+        ParticleReal* timer;                /*!< see #RealIdx::treatment_timer */
+        ParticleReal* prob;                 /*!< see #RealIdx::prob */
+        ParticleReal* incubation_period;    /*!< see #RealIdx::incubation_period */
+        ParticleReal* infectious_period;    /*!< see #RealIdx::infectious_period */
+        ParticleReal* symptomdev_period;    /*!< see #RealIdx::symptomdev_period */
+        const DiseaseParm* parm;            /*!< disease parameters (device) */
+        const Particle<0, 0>* pstruct;      /*!< agent positions */
+        GpuArray<Real, AMREX_SPACEDIM> plo; /*!< lower corner of the domain */
+        GpuArray<Real, AMREX_SPACEDIM> dxi; /*!< inverse cell size */
+        Box domain;                         /*!< domain */
+        /*! Disease events (levels of care entered and left, deaths) by home cell, in the
+            buffer of the grid of the tile for the thread, for progress(); see
+            AgentContainer::updateStatus() */
+        Array4<int> events;
+        Box box;                            /*!< box of the events */
+        bool log_prob;                      /*!< see AgentContainer::m_log_prob */
+        bool schedule;                      /*!< see AgentContainer::m_event_scheduling */
+        int day;                            /*!< day of the status update, see AgentContainer::m_day */
+        CounterRNGSeed rng_seed;            /*!< see AgentContainer::m_rng_seed */
+        /*! First blocks of the counter-based streams of the infection phase (see
+            AgentRNG::fillFirstBlocks()), or nullptr; see AgentContainer::m_batch_rng */
+        const std::uint32_t* infect_blocks = nullptr;
+        /*! Net changes of the number of agents of the tile with each #Status, or nullptr; see
+            AgentContainer::m_incremental_totals */
+        int* status_deltas = nullptr;
+
+        /*! \brief Random numbers of agent i for a phase of the day (see #RNGPhase) */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        AgentRNG rng (int i, RandomEngine const& engine, int phase) const noexcept
+        {
+            if ((phase == RNGPhase::infect) && (infect_blocks != nullptr)) {
+                return AgentRNG(rng_seed, agentStream(pstruct[i]), day, phase, infect_blocks + 4*i);
+            }
+            return AgentRNG(engine, rng_seed, agentStream(pstruct[i]), day, phase);
+        }
+
+        /*! \brief Infect agent i with the probability accumulated in #RealIdx::prob by the
+            interactions of the day, and reset it for the next day (see
+            AgentContainer::infectAgents()); returns whether the agent was infected */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        bool infect (int i, AgentRNG& rng) const noexcept
+        {
+            const ParticleReal p_infect = log_prob ? -std::expm1(prob[i]) : 1.0_prt - prob[i];
+            // probability of not being infected: 1, or log(1) = 0 when accumulated in log space
+            prob[i] = log_prob ? 0.0_prt : 1.0_prt;
+            if ( status[i] == Status::never ||
+                 status[i] == Status::susceptible ) {
+                if (rng.uniform() < p_infect) {
+                    set_status(i, Status::infected);
+                    counter[i] = 0.0;
+                    timer[i] = 0.0;
+                    incubation_period[i] = static_cast<ParticleReal>(rng.normal(parm->incubation_length_mean, parm->incubation_length_std));
+                    infectious_period[i] = static_cast<ParticleReal>(rng.normal(parm->infectious_length_mean, parm->infectious_length_std));
+                    symptomdev_period[i] = static_cast<ParticleReal>(rng.normal(parm->symptomdev_length_mean, parm->symptomdev_length_std));
+                    // infected at the end of the day before the status update of #day
+                    event_day[i] = schedule ? next_event_day(i, day - 1) : -1;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /*! \brief Advance the disease of agent i by one day (see AgentContainer::updateStatus()) */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        void progress (int i, AgentRNG& rng) const noexcept
+        {
+            if (status[i] == Status::immune) {
+                if ((event_day[i] >= 0) && (day >= event_day[i])) { lose_immunity(i); }
+                return;
+            }
+            if (status[i] != Status::infected) {
+                return;
+            }
+            counter[i] += 1;
+            if (counter[i] < incubation_period[i]) {
+                // incubation phase
+                return;
+            }
+            const IntVect iv = event_cell(i);
+            if (counter[i] == amrex::Math::ceil(incubation_period[i])) {
+                decide_care(i, iv, rng);
+            } else if (timer[i] > 0.0_prt) {
+                // count down the stay, which ends at the exit timer of the highest level
+                timer[i] -= 1.0_prt;
+                for (int k = 0; k < parm->ncare_levels; ++k) {
+                    if (timer[i] != static_cast<ParticleReal>(parm->care_exit_timer[k])) { continue; }
+                    end_care(i, k, iv, rng);
+                    break;
+                }
+            } else if (counter[i] >= (incubation_period[i] + infectious_period[i])) {
+                // not receiving care, recover once not infectious
+                recover(i);
+            }
+        }
+
+        /*! \brief Apply the disease event of agent i scheduled on #day, with the same outcome
+            as the progress() of the days since its previous event, and schedule its next event
+            (see AgentContainer::m_event_scheduling)
+
+            #RealIdx::disease_counter is only updated at the events: it stays 0 during the
+            incubation period and is then set to its value at the end of the incubation, so
+            that comparing it with #RealIdx::incubation_period still tells the infectious
+            agents. #RealIdx::treatment_timer is set to its exit value at the end of the stay.
+        */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        void process_event (int i, AgentRNG& rng) const noexcept
+        {
+            if (status[i] == Status::immune) {
+                lose_immunity(i);
+                return;
+            }
+            if (status[i] != Status::infected) {
+                event_day[i] = -1;
+                return;
+            }
+            const IntVect iv = event_cell(i);
+            const int infectious_day = static_cast<int>(amrex::Math::ceil(incubation_period[i]));
+            if (timer[i] > 0.0_prt) {
+                // end of the stay in care
+                const int k = care_level(i);
+                timer[i] = static_cast<ParticleReal>(parm->care_exit_timer[k]);
+                end_care(i, k, iv, rng);
+            } else if ((infectious_day >= 1) && (counter[i] < incubation_period[i])) {
+                // end of the incubation period
+                counter[i] = static_cast<ParticleReal>(infectious_day);
+                decide_care(i, iv, rng);
+                event_day[i] = next_event_day(i, day);
+            } else {
+                counter[i] = static_cast<ParticleReal>(recovery_count(i));
+                recover(i);
+            }
+        }
+
+        /*! \brief Day of the next event of infected agent i, given its
+            #RealIdx::disease_counter and #RealIdx::treatment_timer after the status update of
+            \p last_day, i.e. the first day on which progress() would change more than its
+            counters */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        int next_event_day (int i, int last_day) const noexcept
+        {
+            const int c = static_cast<int>(counter[i]);
+            const int infectious_day = static_cast<int>(amrex::Math::ceil(incubation_period[i]));
+            if (timer[i] > 0.0_prt) {
+                return last_day + static_cast<int>(timer[i]) - parm->care_exit_timer[care_level(i)];
+            } else if ((infectious_day >= 1) && (c < infectious_day)) {
+                return last_day + infectious_day - c;
+            } else {
+                return last_day + amrex::max(recovery_count(i) - c, 1);
+            }
+        }
+
+        /*! \brief #RealIdx::disease_counter on the day agent i recovers if it needs no care */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        int recovery_count (int i) const noexcept
+        {
+            const int infectious_day = static_cast<int>(amrex::Math::ceil(incubation_period[i]));
+            int c = amrex::max(1, amrex::max(infectious_day,
+                static_cast<int>(amrex::Math::ceil(incubation_period[i] + infectious_period[i]))));
+            // the agents do not recover on the day the need for care is decided
+            if ((infectious_day >= 1) && (c == infectious_day)) { ++c; }
+            return c;
+        }
+
+        /*! \brief Highest level of care reached by agent i, from its treatment timer */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        int care_level (int i) const noexcept
+        {
+            int level = 0;
+            for (int k = 1; k < parm->ncare_levels; ++k) {
+                if (static_cast<ParticleReal>(parm->care_exit_timer[k]) < timer[i]) { level = k; }
+            }
+            return level;
+        }
+
+        /*! \brief Cell where the events of agent i are recorded: its home, or where it is if
+            its home is away from the box (on a trip) */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        IntVect event_cell (int i) const noexcept
+        {
+            IntVect iv(AMREX_D_DECL(home_i[i], home_j[i], 0));
+            if (!box.contains(iv)) { iv = getParticleCell(pstruct[i], plo, dxi, domain); }
+            AMREX_ASSERT(box.contains(iv));
+            return iv;
+        }
+
+        /*! \brief Decide if agent i needs care at the end of its incubation period, and up to
+            which level, and set its treatment timer */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        void decide_care (int i, IntVect const& iv, AgentRNG& rng) const noexcept
+        {
+            const int age = age_group[i];
+            if (!random_event(parm->care_entry_prob[0][age], rng)) { return; }
+            const Real p_short = parm->care_days_short_prob[age];
+            const bool short_stay = (p_short >= 1.0_rt) || random_event(p_short, rng);
+            timer[i] = static_cast<ParticleReal>(
+                short_stay ? parm->care_days_short[age] : parm->care_days_long[age]);
+            amrex::Gpu::Atomic::AddNoRet(&events(iv, 0), 1);
+            for (int k = 1; k < parm->ncare_levels; ++k) {
+                if (!random_event(parm->care_entry_prob[k][age], rng)) { break; }
+                timer[i] += static_cast<ParticleReal>(parm->care_extra_days[k]);
+                amrex::Gpu::Atomic::AddNoRet(&events(iv, k), 1);
+            }
+        }
+
+        /*! \brief End the stay of agent i, whose highest level of care is k: it dies or
+            recovers */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        void end_care (int i, int k, IntVect const& iv, AgentRNG& rng) const noexcept
+        {
+            const int death = parm->ncare_levels;  // component of the deaths in the disease stats
+            amrex::Gpu::Atomic::AddNoRet(&events(iv, k), -1);
+            if (random_event(parm->care_death_prob[k][age_group[i]], rng)) {
+                amrex::Gpu::Atomic::AddNoRet(&events(iv, death), 1);
+                set_status(i, Status::dead);
+                event_day[i] = -1;
+            } else {
+                recover(i);  // If alive, the patient recovers
+            }
+        }
+
+        /*! \brief Agent i becomes immune, until #DiseaseParm::immune_length days later */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        void recover (int i) const noexcept
+        {
+            set_status(i, Status::immune);
+            event_day[i] = (parm->immune_length > 0) ? day + parm->immune_length : -1;
+        }
+
+        /*! \brief Agent i is no longer immune */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        void lose_immunity (int i) const noexcept
+        {
+            set_status(i, Status::susceptible);
+            event_day[i] = -1;
+        }
+
+        /*! \brief Change the status of agent i, counting the change in #status_deltas */
+        AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+        void set_status (int i, int new_status) const noexcept
+        {
+            if (status_deltas != nullptr) {
+                amrex::Gpu::Atomic::AddNoRet(&status_deltas[static_cast<int>(status[i])], -1);
+                amrex::Gpu::Atomic::AddNoRet(&status_deltas[new_status], 1);
+            }
+            status[i] = new_status;
+        }
+    };
+
+    /*! \brief #DiseaseState of the agents of a tile for the status update of a day, without
+        the events */
+    template <typename PTile>
+    DiseaseState disease_state (PTile& ptile, const Geometry& geom, const DiseaseParm* parm,
+                                bool log_prob, bool schedule, int day, const CounterRNGSeed& rng_seed)
+    {
+        auto& soa = ptile.GetStructOfArrays();
+        DiseaseState state;
+        state.pstruct = ptile.GetArrayOfStructs()().dataPtr();
+        state.plo = geom.ProbLoArray();
+        state.dxi = geom.InvCellSizeArray();
+        state.domain = geom.Domain();
+        state.status = intAttribPtr<IntIdx::status>(soa);
+        state.age_group = intAttribPtr<IntIdx::age_group>(soa);
+        state.home_i = intAttribPtr<IntIdx::home_i>(soa);
+        state.home_j = intAttribPtr<IntIdx::home_j>(soa);
+        state.event_day = intAttribPtr<IntIdx::event_day>(soa);
+        state.counter = soa.GetRealData(RealIdx::disease_counter).data();
+        state.timer = soa.GetRealData(RealIdx::treatment_timer).data();
+        state.prob = soa.GetRealData(RealIdx::prob).data();
+        state.incubation_period = soa.GetRealData(RealIdx::incubation_period).data();
+        state.infectious_period = soa.GetRealData(RealIdx::infectious_period).data();
+        state.symptomdev_period = soa.GetRealData(RealIdx::symptomdev_period).data();
+        state.parm = parm;
+        state.log_prob = log_prob;
+        state.schedule = schedule;
+        state.day = day;
+        state.rng_seed = rng_seed;
+        return state;
+    }
+
+    /*! \brief Integer buffers of the disease events of a level (see #DiseaseState::events), one
+        per grid and thread, allocated over the valid box of the grid the first time the thread
+        updates a tile of that grid */
+    struct DiseaseEvents
+    {
+        explicit DiseaseEvents (int a_ncomp)
+            : buffers(OpenMP::get_max_threads()), ncomp(a_ncomp) {}
+
+        /*! \brief Buffer of the calling thread for grid \p grid of valid box \p box */
+        IArrayBox& get (int grid, const Box& box)
+        {
+            auto& fab = buffers[OpenMP::get_thread_num()][grid];
+            if (!fab.isAllocated()) {
+                fab.resize(box, ncomp);
+                fab.setVal<RunOn::Device>(0);
+            }
+            return fab;
+        }
+
+        Vector<std::map<int, IArrayBox> > buffers;  /*!< buffers of each thread, by grid */
+        int ncomp;                                  /*!< number of components */
+    };
+
+    /*! \brief Add the disease events of a level to the disease stats, one grid per thread
+
+        The events are integers, so their sums do not depend on the tiles each thread updated. */
+    void add_disease_events (MultiFab& disease_stats, DiseaseEvents const& events)
+    {
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for (MFIter mfi(disease_stats); mfi.isValid(); ++mfi)
+        {
+            auto ds = disease_stats.array(mfi);
+            for (auto const& thread_buffers : events.buffers) {
+                auto found = thread_buffers.find(mfi.index());
+                if (found == thread_buffers.end()) { continue; }
+                auto ev = found->second.const_array();
+                amrex::ParallelFor(found->second.box(), found->second.nComp(),
+                [=] AMREX_GPU_DEVICE (int i, int j, int k, int n) noexcept
+                {
+                    ds(i, j, k, n) += static_cast<Real>(ev(i, j, k, n));
+                });
+            }
+        }
+        Gpu::streamSynchronize();
+    }
+
+    /*! \brief Add the changes of the number of agents with each #Status of the tiles of a level
+        (see #DiseaseState::status_deltas) to the totals of AgentContainer::m_incremental_totals */
+    void add_status_deltas (std::array<Long, 5>& totals, Gpu::DeviceVector<int> const& tile_deltas)
+    {
+        Vector<int> h_deltas(tile_deltas.size());
+        Gpu::copy(Gpu::deviceToHost, tile_deltas.begin(), tile_deltas.end(), h_deltas.begin());
+        for (Long n = 0; n < h_deltas.size(); ++n) { totals[n % 5] += h_deltas[n]; }
+    }
+
+    /*! \brief Whether an agent belongs to the index of AgentContainer::m_active_index: it is
+        infected, or, without AgentContainer::m_event_scheduling, immune until a given day */
+    AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+    bool is_active (int status, int event_day, bool schedule) noexcept
+    {
+        return (status == Status::infected)
+            || (!schedule && (status == Status::immune) && (event_day >= 0));
+    }
+
+    /*! \brief Advance the disease of the agents of the index of a tile by one day (unless
+        this is done by the events, see AgentContainer::m_event_scheduling), and remove the
+        agents who are no longer active from the index (see AgentContainer::m_active_index) */
+    void progress_active (ActiveIndex& index, DiseaseState const& state)
+    {
+        auto inds = index.inds.dataPtr();
+        const int count = index.count;
+        if (count == 0) { return; }
+
+        if (!state.schedule) {
+            amrex::ParallelForRNG( count,
+            [=] AMREX_GPU_DEVICE (int k, amrex::RandomEngine const& engine) noexcept
+            {
+                auto rng = state.rng(inds[k], engine, RNGPhase::update_status);
+                state.progress(inds[k], rng);
+            });
+        }
+
+        // stream compaction of the agents still active, in the same order
+        Gpu::DeviceVector<int> kept_d(count);
+        auto kept = kept_d.dataPtr();
+        auto status_ptr = state.status;
+        auto event_day_ptr = state.event_day;
+        const bool schedule = state.schedule;
+        index.count = Scan::PrefixSum<int>(count,
+            [=] AMREX_GPU_DEVICE (int k) -> int {
+                return is_active(status_ptr[inds[k]], event_day_ptr[inds[k]], schedule) ? 1 : 0;
+            },
+            [=] AMREX_GPU_DEVICE (int k, int const& x) {
+                if (is_active(status_ptr[inds[k]], event_day_ptr[inds[k]], schedule)) { kept[x] = inds[k]; }
+            },
+            Scan::Type::exclusive, Scan::retSum);
+        Gpu::copyAsync(Gpu::deviceToDevice, kept_d.begin(), kept_d.begin() + index.count, index.inds.begin());
+        Gpu::streamSynchronize();
+    }
+
+    /*! \brief Add agents to the slots of the days of their next events in a timer wheel (see
+        #EventWheel); the agents are list[0:n], or 0 to n-1 if list is null, and those without
+        a next event are skipped */
+    void schedule_events (EventWheel& wheel, const int* list, int n, const int* event_day)
+    {
+        constexpr int nslots = EventWheel::nslots;
+        if (n == 0) { return; }
+
+        Gpu::DeviceVector<int> slot_count_d(nslots, 0);
+        auto slot_count = slot_count_d.dataPtr();
+        amrex::ParallelFor(n, [=] AMREX_GPU_DEVICE (int k) noexcept
+        {
+            const int day = event_day[list ? list[k] : k];
+            if (day >= 0) { amrex::Gpu::Atomic::AddNoRet(&slot_count[day % nslots], 1); }
+        });
+        Vector<int> h_slot_count(nslots);
+        Gpu::copy(Gpu::deviceToHost, slot_count_d.begin(), slot_count_d.end(), h_slot_count.begin());
+
+        // grow the slots, and append the agents at their old ends
+        Vector<int*> h_slot_ptr(nslots);
+        for (int s = 0; s < nslots; ++s) {
+            const auto old_size = static_cast<int>(wheel.slots[s].size());
+            wheel.slots[s].resize(old_size + h_slot_count[s]);
+            h_slot_ptr[s] = wheel.slots[s].dataPtr();
+            h_slot_count[s] = old_size;
+        }
+        Gpu::DeviceVector<int*> slot_ptr_d(nslots);
+        Gpu::copy(Gpu::hostToDevice, h_slot_ptr.begin(), h_slot_ptr.end(), slot_ptr_d.begin());
+        Gpu::copy(Gpu::hostToDevice, h_slot_count.begin(), h_slot_count.end(), slot_count_d.begin());
+        auto slot_ptr = slot_ptr_d.dataPtr();
+        amrex::ParallelFor(n, [=] AMREX_GPU_DEVICE (int k) noexcept
+        {
+            const int i = list ? list[k] : k;
+            const int day = event_day[i];
+            if (day >= 0) {
+                const int s = day % nslots;
+                slot_ptr[s][amrex::Gpu::Atomic::Add(&slot_count[s], 1)] = i;
+            }
+        });
+        Gpu::streamSynchronize();
+    }
+
+    /*! \brief Apply the disease events of the day of the agents of a tile (see
+        DiseaseState::process_event()), and move them to the slots of their next events */
+    void process_events (EventWheel& wheel, DiseaseState const& state)
+    {
+        Gpu::DeviceVector<int> due;
+        due.swap(wheel.slots[state.day % EventWheel::nslots]);
+        const int n = static_cast<int>(due.size());
+        if (n == 0) { return; }
+
+        auto due_ptr = due.dataPtr();
+        amrex::ParallelForRNG( n,
+        [=] AMREX_GPU_DEVICE (int k, amrex::RandomEngine const& engine) noexcept
+        {
+            const int i = due_ptr[k];
+            // the events of a later turn of the wheel stay in the slot
+            if (state.event_day[i] == state.day) {
+                auto rng = state.rng(i, engine, RNGPhase::update_status);
+                state.process_event(i, rng);
+            }
+        });
+        schedule_events(wheel, due_ptr, n, state.event_day);
+    }
+
+    /*! \brief Infect the agents of a tile (see DiseaseState::infect()) and then call
+        f(i, engine) for each agent i, in a single pass; the newly infected agents are
+        appended to the index of the tile and scheduled on its event wheel, if given. With
+        batch_rng and counter-based streams, the first random numbers of all the agents are
+        generated beforehand in a vectorized loop (CPU only). */
+    template <typename F>
+    void infect_tile (int np, DiseaseState state, ActiveIndex* index, EventWheel* wheel,
+                      bool batch_rng, F const& f)
+    {
+#ifndef AMREX_USE_GPU
+        // reused by the tiles of each thread
+        static thread_local Vector<std::uint32_t> blocks;
+        if (batch_rng && state.rng_seed.enabled) {
+            blocks.resize(4*static_cast<std::size_t>(np));
+            AgentRNG::fillFirstBlocks(state.pstruct, np, state.rng_seed, state.day,
+                                      RNGPhase::infect, blocks.data());
+            state.infect_blocks = blocks.data();
+        }
+#else
+        amrex::ignore_unused(batch_rng);
+#endif
+
+        if ((index == nullptr) && (wheel == nullptr)) {
+            amrex::ParallelForRNG( np,
+            [=] AMREX_GPU_DEVICE (int i, amrex::RandomEngine const& engine) noexcept
+            {
+                auto rng = state.rng(i, engine, RNGPhase::infect);
+                state.infect(i, rng);
+                f(i, engine);
+            });
+            return;
+        }
+
+        // list of the newly infected agents: the end of the index if any
+        Gpu::DeviceVector<int> new_inds((index == nullptr) ? np : 0);
+        int* inds = (index == nullptr) ? new_inds.dataPtr() : index->inds.dataPtr();
+        const int first = (index == nullptr) ? 0 : index->count;
+        Gpu::DeviceScalar<int> count_d(first);
+        auto count_ptr = count_d.dataPtr();
+        amrex::ParallelForRNG( np,
+        [=] AMREX_GPU_DEVICE (int i, amrex::RandomEngine const& engine) noexcept
+        {
+            auto rng = state.rng(i, engine, RNGPhase::infect);
+            if (state.infect(i, rng)) {
+                inds[amrex::Gpu::Atomic::Add(count_ptr, 1)] = i;
+            }
+            f(i, engine);
+        });
+        const int count = count_d.dataValue();
+        if (index != nullptr) { index->count = count; }
+        if (wheel != nullptr) { schedule_events(*wheel, inds + first, count - first, state.event_day); }
+    }
+
+    /*! \brief Move the running product of escape probabilities into log space before it
+        underflows (see AgentContainer::interactAgentsHomeWork()) */
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    void fold_escape (Real& prob, Real& log_escape) noexcept
+    {
+        if (prob < Real(1.e-30)) {
+            log_escape += std::log(prob);
+            prob = Real(1.0);
+        }
+    }
+
+    /*! \brief Sort an array of agent indices in place by a key, and then by a tie-break key
+        (Shell sort) */
+    template <typename F, typename T>
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    void sort_by_key (unsigned int* a, int n, F const& key, T const& tie) noexcept
+    {
+        int h = 1;
+        while (h < n/3) { h = 3*h + 1; }
+        for (; h > 0; h = (h - 1)/3) {
+            for (int p = h; p < n; ++p) {
+                unsigned int v = a[p];
+                auto kv = key(v);
+                auto tv = tie(v);
+                int q = p;
+                while (q >= h && ((key(a[q-h]) > kv) || ((key(a[q-h]) == kv) && (tie(a[q-h]) > tv)))) {
+                    a[q] = a[q-h];
+                    q -= h;
+                }
+                a[q] = v;
+            }
+        }
+    }
+
+    /*! \brief Mixing groups used as keys of the infectious-pressure table in
+        AgentContainer::interactAgentsHomeWorkAggregated() */
+    struct MixingKey
+    {
+        enum {
+            family = 0,        /*!< same family and neighborhood (all transmitters) */
+            family_nw,         /*!< same family and neighborhood (non-withdrawn transmitters) */
+            nc,                /*!< neighborhood cluster (family/4) (non-withdrawn transmitters) */
+            comm,              /*!< whole community */
+            hood,              /*!< neighborhood */
+            work,              /*!< workgroup */
+            daycare,           /*!< neighborhood daycare/playgroup */
+            school,            /*!< elementary/middle/high school */
+            nkeys
+        };
+    };
+
+    /*! Number of transmitter classes (see #XmitClass) */
+    constexpr int num_xmit_classes = XmitClass::nclasses;
+
+    /*! Marks an empty slot of the infectious-pressure table */
+    constexpr unsigned long long empty_key = ~0ULL;
+
+    /*! \brief Packs a mixing group type, tile-local cell index, and group value into a table key */
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    unsigned long long mixing_key (int type, unsigned int cell, unsigned int value) noexcept
+    {
+        return (static_cast<unsigned long long>(type) << 60)
+            | (static_cast<unsigned long long>(cell & 0x0FFFFFFFu) << 32)
+            | static_cast<unsigned long long>(value);
+    }
+
+    /*! \brief Slot of a key in an open-addressing hash table of size mask+1 */
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    unsigned int mixing_slot (unsigned long long key, unsigned int mask) noexcept
+    {
+        // splitmix64 finalizer
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return static_cast<unsigned int>(key) & mask;
+    }
+
+    /*! \brief Insert a key (if not present) into the hash table and return its slot */
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    unsigned int mixing_insert (unsigned long long* keys, unsigned int mask,
+                                unsigned long long key) noexcept
+    {
+        unsigned int slot = mixing_slot(key, mask);
+        while (true) {
+            unsigned long long old = Gpu::Atomic::CAS(&keys[slot], empty_key, key);
+            if (old == empty_key || old == key) { return slot; }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    /*! \brief Find the slot of a key in the hash table; returns -1 if not present */
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    int mixing_find (const unsigned long long* keys, unsigned int mask,
+                     unsigned long long key) noexcept
+    {
+        unsigned int slot = mixing_slot(key, mask);
+        while (true) {
+            unsigned long long k = keys[slot];
+            if (k == key) { return static_cast<int>(slot); }
+            if (k == empty_key) { return -1; }
+            slot = (slot + 1) & mask;
+        }
+    }
 }
 
 /*! \brief Initialize agents for ExaEpi::ICType::Demo */
@@ -216,9 +1158,13 @@ void AgentContainer::initAgentsDemo (iMultiFab& /*num_residents*/,
     auto& soa   = ptile.GetStructOfArrays();
     auto& aos   = ptile.GetArrayOfStructs();
     auto pstruct_ptr = aos().data();
-    auto status_ptr = soa.GetIntData(IntIdx::status).data();
-    auto strain_ptr = soa.GetIntData(IntIdx::strain).data();
+    auto status_ptr = intAttribPtr<IntIdx::status>(soa);
+    auto strain_ptr = intAttribPtr<IntIdx::strain>(soa);
+    auto trip_timer_ptr = intAttribPtr<IntIdx::trip_timer>(soa);
+    auto event_day_ptr = intAttribPtr<IntIdx::event_day>(soa);
     auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
+    auto prob_ptr = soa.GetRealData(RealIdx::prob).data();
+    const ParticleReal prob_init = m_log_prob ? 0.0_prt : 1.0_prt;
 
     auto cell_offsets_ptr = cell_offsets_d.data();
     auto cell_indices_ptr = cell_indices_d.data();
@@ -237,13 +1183,16 @@ void AgentContainer::initAgentsDemo (iMultiFab& /*num_residents*/,
 
         for (int i = cell_start; i < cell_stop; ++i) {
             auto& p = pstruct_ptr[i];
-            p.pos(0) = idx + 0.5;
-            p.pos(1) = idy + 0.5;
+            p.pos(0) = static_cast<ParticleReal>(idx + 0.5);
+            p.pos(1) = static_cast<ParticleReal>(idy + 0.5);
             p.id() = i;
             p.cpu() = 0;
 
             counter_ptr[i] = 0.0;
+            prob_ptr[i] = prob_init;
             strain_ptr[i] = 0;
+            trip_timer_ptr[i] = 0;
+            event_day_ptr[i] = -1;
 
             if (amrex::Random(engine) < 1e-6) {
                 status_ptr[i] = 1;
@@ -320,7 +1269,14 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
 
     using AgentType = ParticleType;
 
+    m_ncommunity = demo.Ncommunity;
+
     const Box& domain = Geom(0).Domain();
+    const CounterRNGSeed rng_seed = m_rng_seed;
+    // bound on the number of agents of a community, for the ids of the agents (see below)
+    constexpr Long max_community_size = 2048;
+    AMREX_ALWAYS_ASSERT(!rng_seed.enabled
+                        || (max_community_size*Geom(0).Domain().numPts() < LastParticleID));
 
     num_residents.setVal(0);
     unit_mf.setVal(-1);
@@ -371,6 +1327,7 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
             int community = (int) domain.index(IntVect(AMREX_D_DECL(i, j, k)));
             if (community >= Ncommunity) { return; }
             comm_arr(i, j, k) = community;
+            AgentRNG rng(engine, rng_seed, community, 0, RNGPhase::census_families);
 
             int unit = 0;
             while (community >= Start[unit+1]) { unit++; }
@@ -404,7 +1361,7 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
 
             int npeople = 0;
             while (npeople < community_size + 1) {
-                int il  = amrex::Random_int(1000, engine);
+                int il  = rng.uniform_int(1000);
 
                 int family_size = 1;
                 while (il > p_hh[family_size]) { ++family_size; }
@@ -460,19 +1417,23 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
         auto aos = &agents_tile.GetArrayOfStructs()[0];
         auto& soa = agents_tile.GetStructOfArrays();
 
-        auto status_ptr = soa.GetIntData(IntIdx::status).data();
-        auto age_group_ptr = soa.GetIntData(IntIdx::age_group).data();
-        auto family_ptr = soa.GetIntData(IntIdx::family).data();
-        auto home_i_ptr = soa.GetIntData(IntIdx::home_i).data();
-        auto home_j_ptr = soa.GetIntData(IntIdx::home_j).data();
-        auto work_i_ptr = soa.GetIntData(IntIdx::work_i).data();
-        auto work_j_ptr = soa.GetIntData(IntIdx::work_j).data();
-        auto nborhood_ptr = soa.GetIntData(IntIdx::nborhood).data();
-        auto school_ptr = soa.GetIntData(IntIdx::school).data();
-        auto workgroup_ptr = soa.GetIntData(IntIdx::workgroup).data();
-        auto work_nborhood_ptr = soa.GetIntData(IntIdx::work_nborhood).data();
+        auto status_ptr = intAttribPtr<IntIdx::status>(soa);
+        auto age_group_ptr = intAttribPtr<IntIdx::age_group>(soa);
+        auto family_ptr = intAttribPtr<IntIdx::family>(soa);
+        auto home_i_ptr = intAttribPtr<IntIdx::home_i>(soa);
+        auto home_j_ptr = intAttribPtr<IntIdx::home_j>(soa);
+        auto work_i_ptr = intAttribPtr<IntIdx::work_i>(soa);
+        auto work_j_ptr = intAttribPtr<IntIdx::work_j>(soa);
+        auto nborhood_ptr = intAttribPtr<IntIdx::nborhood>(soa);
+        auto school_ptr = intAttribPtr<IntIdx::school>(soa);
+        auto workgroup_ptr = intAttribPtr<IntIdx::workgroup>(soa);
+        auto work_nborhood_ptr = intAttribPtr<IntIdx::work_nborhood>(soa);
+        auto trip_timer_ptr = intAttribPtr<IntIdx::trip_timer>(soa);
+        auto event_day_ptr = intAttribPtr<IntIdx::event_day>(soa);
 
         auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
+        auto prob_ptr = soa.GetRealData(RealIdx::prob).data();
+        const ParticleReal prob_init = m_log_prob ? 0.0_prt : 1.0_prt;
         auto dx = ParticleGeom(0).CellSizeArray();
         auto my_proc = ParallelDescriptor::MyProc();
 
@@ -517,11 +1478,18 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
                 }
             }
 
+            // with counter-based random streams, the agents are numbered within each community,
+            // so that their ids (the keys of their streams) do not depend on the decomposition
+            AgentRNG rng(engine, rng_seed, 8*static_cast<std::uint64_t>(community) + n, 0, RNGPhase::census_agents);
+            int first_in_community = 0;
+            for (int m = 0; m < n; ++m) { first_in_community += (m + 1)*nf_arr(i, j, k, m); }
+            AMREX_ASSERT(first_in_community + num_to_add <= max_community_size);
+
             int start = offset_arr(i, j, k, n);
             for (int ip = start; ip < start + num_to_add; ++ip) {
                 auto& agent = aos[ip];
-                int il2 = amrex::Random_int(100, engine);
-                int nborhood = amrex::Random_int(4, engine);
+                int il2 = rng.uniform_int(100);
+                int nborhood = rng.uniform_int(4);
                 int age_group = -1;
 
                 if (family_size == 1) {
@@ -532,12 +1500,12 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
                 } else if (family_size == 2) {
                     if (il2 == 0) {
                         /* 1% probability of one parent + one child */
-                        int il3 = amrex::Random_int(100, engine);
+                        int il3 = rng.uniform_int(100);
                         if (il3 < 2) { age_group = 4; }        /* one parent, age 65+ */
                         else if (il3 < 62) { age_group = 3; }  /* one parent 30-64 (ASSUME 60%) */
                         else { age_group = 2; }                /* one parent 19-29 */
                         nr_arr(i, j, k, age_group) += 1;
-                        if (((int) amrex::Random_int(100, engine)) < p_schoolage) {
+                        if (((int) rng.uniform_int(100)) < p_schoolage) {
                             age_group = 1; /* 22.0% of total population ages 5-18 */
                         } else {
                             age_group = 0;   /* 6.8% of total population ages 0-4 */
@@ -561,7 +1529,7 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
 
                     /* Now pick the children's age groups */
                     for (int nc = 2; nc < family_size; ++nc) {
-                        if (((int) amrex::Random_int(100, engine)) < p_schoolage) {
+                        if (((int) rng.uniform_int(100)) < p_schoolage) {
                             age_group = 1; /* 22.0% of total population ages 5-18 */
                         } else {
                             age_group = 0;   /* 6.8% of total population ages 0-4 */
@@ -570,13 +1538,20 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
                     }
                 }
 
-                agent.pos(0) = (i + 0.5)*dx[0];
-                agent.pos(1) = (j + 0.5)*dx[1];
-                agent.id()  = pid+ip;
-                agent.cpu() = my_proc;
+                agent.pos(0) = static_cast<ParticleReal>((i + 0.5)*dx[0]);
+                agent.pos(1) = static_cast<ParticleReal>((j + 0.5)*dx[1]);
+                if (rng_seed.enabled) {
+                    agent.id()  = 1 + max_community_size*static_cast<Long>(community)
+                        + first_in_community + (ip - start);
+                    agent.cpu() = 0;
+                } else {
+                    agent.id()  = pid+ip;
+                    agent.cpu() = my_proc;
+                }
 
                 status_ptr[ip] = 0;
                 counter_ptr[ip] = 0.0;
+                prob_ptr[ip] = prob_init;
                 age_group_ptr[ip] = age_group;
                 family_ptr[ip] = family_id++;
                 home_i_ptr[ip] = i;
@@ -586,11 +1561,13 @@ void AgentContainer::initAgentsCensus (iMultiFab& num_residents,    /*!< Number
                 nborhood_ptr[ip] = nborhood;
                 work_nborhood_ptr[ip] = 5*nborhood;
                 workgroup_ptr[ip] = 0;
+                trip_timer_ptr[ip] = 0;
+                event_day_ptr[ip] = -1;
 
                 if (age_group == 0) {
                     school_ptr[ip] = 5; // note - need to handle playgroups
                 } else if (age_group == 1) {
-                    school_ptr[ip] = assign_school(nborhood, engine);
+                    school_ptr[ip] = assign_school(nborhood, rng);
                 } else{
                     school_ptr[ip] = -1;
                 }
@@ -646,6 +1623,9 @@ void AgentContainer::moveAgentsToWork ()
 {
     BL_PROFILE("AgentContainer::moveAgentsToWork");
 
+    // the bins are computed from the work community indices instead (see agentBin())
+    if (m_position_free_commute) { return; }
+
     for (int lev = 0; lev <= finestLevel(); ++lev)
     {
         const auto dx = Geom(lev).CellSizeArray();
@@ -664,15 +1644,17 @@ void AgentContainer::moveAgentsToWork ()
             const size_t np = aos.numParticles();
 
             auto& soa = ptile.GetStructOfArrays();
-            auto work_i_ptr = soa.GetIntData(IntIdx::work_i).data();
-            auto work_j_ptr = soa.GetIntData(IntIdx::work_j).data();
+            auto work_i_ptr = intAttribPtr<IntIdx::work_i>(soa);
+            auto work_j_ptr = intAttribPtr<IntIdx::work_j>(soa);
+            auto trip_timer_ptr = intAttribPtr<IntIdx::trip_timer>(soa);
 
             amrex::ParallelFor( np,
             [=] AMREX_GPU_DEVICE (int ip) noexcept
             {
+                if (trip_timer_ptr[ip] > 0) { return; }  // on a trip, see moveRandomTravel()
                 ParticleType& p = pstruct[ip];
-                p.pos(0) = (work_i_ptr[ip] + 0.5)*dx[0];
-                p.pos(1) = (work_j_ptr[ip] + 0.5)*dx[1];
+                p.pos(0) = static_cast<ParticleReal>((work_i_ptr[ip] + 0.5)*dx[0]);
+                p.pos(1) = static_cast<ParticleReal>((work_j_ptr[ip] + 0.5)*dx[1]);
             });
         }
     }
@@ -686,6 +1668,9 @@ void AgentContainer::moveAgentsToHome ()
 {
     BL_PROFILE("AgentContainer::moveAgentsToHome");
 
+    // the bins are computed from the home community indices instead (see agentBin())
+    if (m_position_free_commute) { return; }
+
     for (int lev = 0; lev <= finestLevel(); ++lev)
     {
         const auto dx = Geom(lev).CellSizeArray();
@@ -704,80 +1689,323 @@ void AgentContainer::moveAgentsToHome ()
             const size_t np = aos.numParticles();
 
             auto& soa = ptile.GetStructOfArrays();
-            auto home_i_ptr = soa.GetIntData(IntIdx::home_i).data();
-            auto home_j_ptr = soa.GetIntData(IntIdx::home_j).data();
+            auto home_i_ptr = intAttribPtr<IntIdx::home_i>(soa);
+            auto home_j_ptr = intAttribPtr<IntIdx::home_j>(soa);
+            auto trip_timer_ptr = intAttribPtr<IntIdx::trip_timer>(soa);
 
             amrex::ParallelFor( np,
             [=] AMREX_GPU_DEVICE (int ip) noexcept
             {
+                if (trip_timer_ptr[ip] > 0) { return; }  // on a trip, see moveRandomTravel()
                 ParticleType& p = pstruct[ip];
-                p.pos(0) = (home_i_ptr[ip] + 0.5)*dx[0];
-                p.pos(1) = (home_j_ptr[ip] + 0.5)*dx[1];
+                p.pos(0) = static_cast<ParticleReal>((home_i_ptr[ip] + 0.5)*dx[0]);
+                p.pos(1) = static_cast<ParticleReal>((home_j_ptr[ip] + 0.5)*dx[1]);
             });
         }
     }
 }
 
-/*! \brief Move agents randomly
-
-    For each agent, set its position to a random location with a probabilty of 0.01%
+/*! \brief Send agents on random long-distance trips, and bring them back
+
+    Each agent on a trip (#IntIdx::trip_timer > 0) counts down its trip, and is moved back to
+    its home community when it ends. If \p new_trips, each other living agent goes on a trip
+    with probability #m_random_travel_prob, to a random community of the domain (one of the
+    first #m_ncommunity cells in census mode, which have a community), for
+    #m_random_travel_length days. Agents on a trip stay in the community they visit, at home
+    and at work (see AgentContainer::moveAgentsToWork()).
+
+    Since only a tiny fraction of the agents move, this does not call Redistribute(): the agents
+    that leave their tile are selected by a stream compaction, removed from their tile by moving
+    the last agents of the tile into the holes, and sent directly to the tile that contains their
+    destination, on this or another rank. The tiles are those of the amrex::MFIter loops over
+    the agents (TilingIfNotGPU()), so agents placed by Redistribute(), which are all in the
+    first tile of their grid, are also moved to the tile of their cell. Only the cached bins
+    (see #TileBins) of the tiles that lost or gained agents are rebuilt at the next interaction.
 */
-void AgentContainer::moveRandomTravel ()
+void AgentContainer::moveRandomTravel (bool new_trips /*!< Whether agents may start new trips */)
 {
     BL_PROFILE("AgentContainer::moveRandomTravel");
 
-    for (int lev = 0; lev <= finestLevel(); ++lev)
+    const int lev = 0;
+    const Geometry& geom = Geom(lev);
+    const auto plo = geom.ProbLoArray();
+    const auto dx = geom.CellSizeArray();
+    const auto dxi = geom.InvCellSizeArray();
+    const Box domain = geom.Domain();
+    // the cells past the last community (census mode) have no community to visit
+    const auto ncommunity = static_cast<unsigned int>(
+        (m_ncommunity >= 0) ? Long(m_ncommunity) : domain.numPts());
+    const Real prob = m_random_travel_prob;
+    const int trip_length = m_random_travel_length;
+    const CounterRNGSeed rng_seed = m_rng_seed;
+    const int day = m_day;
+
+    /*! Agent leaving its tile, with the grid of its destination */
+    struct Traveler
     {
-        auto& plev  = GetParticles(lev);
-
-#ifdef AMREX_USE_OMP
-#pragma omp parallel if (Gpu::notInLaunchRegion())
-#endif
-        for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+        int grid;
+        SuperParticleType p;
+    };
+
+    const BoxArray& ba = ParticleBoxArray(lev);
+    const DistributionMapping& dm = ParticleDistributionMap(lev);
+    const int nprocs = ParallelDescriptor::NProcs();
+    Vector<Vector<Traveler> > send(nprocs);
+    std::set<std::pair<int, int> > touched;
+
+    auto& plev = GetParticles(lev);
+    for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        auto& ptile = plev[std::make_pair(mfi.index(), mfi.LocalTileIndex())];
+        auto& soa = ptile.GetStructOfArrays();
+        const int np = static_cast<int>(ptile.numParticles());
+        if (np == 0) { continue; }
+
+        auto pstruct = ptile.GetArrayOfStructs()().dataPtr();
+        auto status_ptr = intAttribPtr<IntIdx::status>(soa);
+        auto home_i_ptr = intAttribPtr<IntIdx::home_i>(soa);
+        auto home_j_ptr = intAttribPtr<IntIdx::home_j>(soa);
+        auto trip_timer_ptr = intAttribPtr<IntIdx::trip_timer>(soa);
+        const Box tbx = mfi.tilebox();
+
+        Gpu::DeviceVector<int> moving(np);
+        auto moving_ptr = moving.dataPtr();
+        Gpu::DeviceScalar<int> any_moved_d(0);
+        auto any_moved = any_moved_d.dataPtr();
+
+        amrex::ParallelForRNG( np,
+        [=] AMREX_GPU_DEVICE (int ip, RandomEngine const& engine) noexcept
         {
-            int gid = mfi.index();
-            int tid = mfi.LocalTileIndex();
-            auto& ptile = plev[std::make_pair(gid, tid)];
-            auto& aos   = ptile.GetArrayOfStructs();
-            ParticleType* pstruct = &(aos[0]);
-            const size_t np = aos.numParticles();
-
-            amrex::ParallelForRNG( np,
-            [=] AMREX_GPU_DEVICE (int i, RandomEngine const& engine) noexcept
-            {
-                ParticleType& p = pstruct[i];
-
-                if (amrex::Random(engine) < 0.0001) {
-                    p.pos(0) = 3000*amrex::Random(engine);
-                    p.pos(1) = 3000*amrex::Random(engine);
+            ParticleType& p = pstruct[ip];
+            bool moved = false;
+            if (trip_timer_ptr[ip] > 0) {
+                trip_timer_ptr[ip] = trip_timer_ptr[ip] - 1;
+                if (trip_timer_ptr[ip] == 0) {
+                    p.pos(0) = static_cast<ParticleReal>((home_i_ptr[ip] + 0.5_rt)*dx[0]);
+                    p.pos(1) = static_cast<ParticleReal>((home_j_ptr[ip] + 0.5_rt)*dx[1]);
+                    moved = true;
                 }
+            } else if (new_trips && (status_ptr[ip] != Status::dead)) {
+                AgentRNG rng(engine, rng_seed, agentStream(p), day, RNGPhase::random_travel);
+                if (rng.uniform() < prob) {
+                    // community i is in cell domain.atOffset(i), see initAgentsCensus()
+                    const IntVect iv = domain.atOffset(Long(rng.uniform_int(ncommunity)));
+                    p.pos(0) = static_cast<ParticleReal>((iv[0] + 0.5_rt)*dx[0]);
+                    p.pos(1) = static_cast<ParticleReal>((iv[1] + 0.5_rt)*dx[1]);
+                    trip_timer_ptr[ip] = trip_length;
+                    moved = true;
+                }
+            }
+            const bool leaving = !tbx.contains(getParticleCell(p, plo, dxi, domain));
+            if (moved || leaving) { *any_moved = 1; }
+            moving_ptr[ip] = leaving ? 1 : 0;
+        });
+        // the bins of the tile change even if the travelers stay in the tile
+        if (any_moved_d.dataValue()) { touched.insert({mfi.index(), mfi.LocalTileIndex()}); }
+
+        // indices of the agents leaving the tile, in increasing order
+        Gpu::DeviceVector<int> moving_inds(np);
+        auto moving_inds_ptr = moving_inds.dataPtr();
+        const int nmove = Scan::PrefixSum<int>(np,
+            [=] AMREX_GPU_DEVICE (int ip) -> int { return moving_ptr[ip]; },
+            [=] AMREX_GPU_DEVICE (int ip, int const& x) {
+                if (moving_ptr[ip]) { moving_inds_ptr[x] = ip; }
+            },
+            Scan::Type::exclusive, Scan::retSum);
+        if (nmove == 0) { continue; }
+
+        auto ptd = ptile.getParticleTileData();
+        Gpu::DeviceVector<SuperParticleType> movers(nmove);
+        auto movers_ptr = movers.dataPtr();
+        amrex::ParallelFor(nmove, [=] AMREX_GPU_DEVICE (int k) noexcept
+        {
+            movers_ptr[k] = ptd.getSuperParticle(moving_inds_ptr[k]);
+        });
+        Vector<SuperParticleType> h_movers(nmove);
+        Vector<int> h_moving_inds(nmove);
+        Gpu::copyAsync(Gpu::deviceToHost, movers.begin(), movers.end(), h_movers.begin());
+        Gpu::copyAsync(Gpu::deviceToHost, moving_inds.begin(), moving_inds.begin() + nmove,
+                       h_moving_inds.begin());
+        Gpu::streamSynchronize();
+
+        // fill the holes left below nkeep with the staying agents above it
+        const int nkeep = np - nmove;
+        Vector<char> tail_moving(nmove, 0);
+        Vector<int> h_dst, h_src;
+        for (int k = 0; k < nmove; ++k) {
+            const int ip = h_moving_inds[k];
+            if (ip < nkeep) { h_dst.push_back(ip); }
+            else { tail_moving[ip - nkeep] = 1; }
+        }
+        for (int ip = nkeep; ip < np; ++ip) {
+            if (!tail_moving[ip - nkeep]) { h_src.push_back(ip); }
+        }
+        AMREX_ASSERT(h_src.size() == h_dst.size());
+        const int nholes = static_cast<int>(h_dst.size());
+        if (nholes > 0) {
+            Gpu::DeviceVector<int> dst(nholes), src(nholes);
+            Gpu::copyAsync(Gpu::hostToDevice, h_dst.begin(), h_dst.end(), dst.begin());
+            Gpu::copyAsync(Gpu::hostToDevice, h_src.begin(), h_src.end(), src.begin());
+            auto dst_ptr = dst.dataPtr();
+            auto src_ptr = src.dataPtr();
+            amrex::ParallelFor(nholes, [=] AMREX_GPU_DEVICE (int k) noexcept
+            {
+                ptd.setSuperParticle(ptd.getSuperParticle(src_ptr[k]), dst_ptr[k]);
             });
+            Gpu::streamSynchronize();
+        }
+        ptile.resize(nkeep);
+
+        // destination grid and rank of each agent leaving the tile
+        for (const auto& sp : h_movers) {
+            const IntVect iv = getParticleCell(sp, plo, dxi, domain);
+            const auto isects = ba.intersections(Box(iv, iv));
+            AMREX_ALWAYS_ASSERT(!isects.empty());
+            const int grid = isects[0].first;
+            send[dm[grid]].push_back(Traveler{grid, sp});
+        }
+    }
+
+    // exchange the travelers between the ranks
+    Vector<Traveler> recv;
+#ifdef AMREX_USE_MPI
+    {
+        BL_PROFILE("AgentContainer::moveRandomTravel::exchange");
+        const int tsize = static_cast<int>(sizeof(Traveler));
+        Vector<int> send_counts(nprocs), send_displs(nprocs, 0);
+        Vector<int> recv_counts(nprocs), recv_displs(nprocs, 0);
+        Vector<Traveler> send_buf;
+        for (int r = 0; r < nprocs; ++r) {
+            send_counts[r] = static_cast<int>(send[r].size())*tsize;
+            if (r > 0) { send_displs[r] = send_displs[r-1] + send_counts[r-1]; }
+            send_buf.insert(send_buf.end(), send[r].begin(), send[r].end());
+        }
+        MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT,
+                     ParallelDescriptor::Communicator());
+        for (int r = 1; r < nprocs; ++r) { recv_displs[r] = recv_displs[r-1] + recv_counts[r-1]; }
+        recv.resize((recv_displs[nprocs-1] + recv_counts[nprocs-1])/tsize);
+        MPI_Alltoallv(send_buf.data(), send_counts.data(), send_displs.data(), MPI_BYTE,
+                      recv.data(), recv_counts.data(), recv_displs.data(), MPI_BYTE,
+                      ParallelDescriptor::Communicator());
+    }
+#else
+    recv = std::move(send[0]);
+#endif
+
+    // append the arriving agents to the tiles of the MFIter loops that contain their cell
+    std::map<int, Vector<std::pair<Box, int> > > grid_tiles;
+    if (!recv.empty()) {
+        for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+            grid_tiles[mfi.index()].push_back({mfi.tilebox(), mfi.LocalTileIndex()});
+        }
+    }
+    std::map<std::pair<int, int>, Vector<SuperParticleType> > arrivals;
+    for (const auto& t : recv) {
+        const IntVect iv = getParticleCell(t.p, plo, dxi, domain);
+        int tile = -1;
+        for (const auto& [tbx, tid] : grid_tiles[t.grid]) {
+            if (tbx.contains(iv)) { tile = tid; break; }
+        }
+        AMREX_ALWAYS_ASSERT(tile >= 0);
+        arrivals[{t.grid, tile}].push_back(t.p);
+    }
+    for (auto& [key, h_agents] : arrivals) {
+        touched.insert(key);
+        auto& ptile = DefineAndReturnParticleTile(lev, key.first, key.second);
+        const int nold = static_cast<int>(ptile.numParticles());
+        const int nnew = static_cast<int>(h_agents.size());
+        ptile.resize(nold + nnew);
+        Gpu::DeviceVector<SuperParticleType> agents(nnew);
+        Gpu::copyAsync(Gpu::hostToDevice, h_agents.begin(), h_agents.end(), agents.begin());
+        auto agents_ptr = agents.dataPtr();
+        auto ptd = ptile.getParticleTileData();
+        amrex::ParallelFor(nnew, [=] AMREX_GPU_DEVICE (int k) noexcept
+        {
+            ptd.setSuperParticle(agents_ptr[k], nold + k);
+        });
+        Gpu::streamSynchronize();
+    }
+
+    // rebuild the cached bins, active indices and event wheels of the tiles that have changed only
+    if (touched.empty()) { return; }
+    for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        if (!touched.count({mfi.index(), mfi.LocalTileIndex()})) { continue; }
+
+        // every agent of the tile is now in its tile box
+        auto& ptile = plev[std::make_pair(mfi.index(), mfi.LocalTileIndex())];
+        auto pstruct = ptile.GetArrayOfStructs()().dataPtr();
+        const Box tbx = mfi.tilebox();
+        const int nout = Reduce::Sum<int>(static_cast<int>(ptile.numParticles()),
+            [=] AMREX_GPU_DEVICE (int ip) noexcept -> int
+            {
+                return tbx.contains(getParticleCell(pstruct[ip], plo, dxi, domain)) ? 0 : 1;
+            });
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(nout == 0, "moveRandomTravel: agents outside of their tile");
+
+        for (auto* bins_store : {&m_bins_home, &m_bins_work}) {
+            if ((static_cast<int>(bins_store->size()) > lev)
+                && (mfi.tileIndex() < static_cast<int>((*bins_store)[lev].size()))) {
+                (*bins_store)[lev][mfi.tileIndex()].np = -1;
+            }
+        }
+        if ((static_cast<int>(m_active.size()) > lev)
+            && (mfi.tileIndex() < static_cast<int>(m_active[lev].size()))) {
+            m_active[lev][mfi.tileIndex()].np = -1;
+        }
+        if ((static_cast<int>(m_wheels.size()) > lev)
+            && (mfi.tileIndex() < static_cast<int>(m_wheels[lev].size()))) {
+            m_wheels[lev][mfi.tileIndex()].np = -1;
         }
     }
 }
 
 /*! \brief Updates disease status of each agent at a given step and also updates a MultiFab
-    that tracks disease statistics (hospitalization, ICU, ventilator, and death) in a community.
+    that tracks disease statistics (levels of care and death) in a community.
 
     At a given step, update the disease status of each agent based on the following overall logic:
     + If agent status is #Status::never or #Status::susceptible, do nothing
+    + If agent status is #Status::immune, it becomes #Status::susceptible
+      #DiseaseParm::immune_length days after its recovery, if positive
     + If agent status is #Status::infected, then
       + Increment its counter by 1 day
       + If counter is within incubation period (#DiseaseParm::incubation_length days), do nothing more
-      + Else on day #DiseaseParm::incubation_length, use hospitalization probabilities (by age group)
-        to decide if agent is hospitalized. If yes, use age group to set hospital timer. Also, use
-        age-group-wise probabilities to move agent to ICU and then to ventilator. Adjust timer
-        accordingly.
-      + Update the community-wise disease stats tracker MultiFab according to hospitalization/ICU/vent
-        status (using the agent's home community)
-      + Else (beyond 3 days), count down hospital timer if agent is hospitalized. At end of hospital
-        stay, determine if agent is #Status dead or #Status::immune. For non-hospitalized agents,
-        set them to #Status::immune after #DiseaseParm::incubation_length +
+      + Else on day #DiseaseParm::incubation_length, use the disease progression table of
+        #DiseaseParm to decide if the agent needs care: it enters level 0 of care (hospital) with
+        probability #DiseaseParm::care_entry_prob[0] for its age group, and its treatment timer
+        is set to the length of stay for its age group. It then moves on to each next level
+        (ICU, ventilator) with probability #DiseaseParm::care_entry_prob[k], which adds
+        #DiseaseParm::care_extra_days[k] to its timer.
+      + Update the community-wise disease stats tracker MultiFab for each level of care entered
+        (using the agent's home community)
+      + Else, count down the treatment timer if the agent is receiving care. When it reaches
+        #DiseaseParm::care_exit_timer for the highest level of care of the agent, the agent
+        dies with probability #DiseaseParm::care_death_prob, or becomes #Status::immune.
+        Agents not receiving care become #Status::immune after #DiseaseParm::incubation_length +
         #DiseaseParm::infectious_length days.
 
-    The input argument is a MultiFab with 4 components corresponding to "hospitalizations", "ICU",
-    "ventilator", and "death". It contains the cumulative totals of these quantities for each
-    community as the simulation progresses.
+    The table is read from the inputs in the AgentContainer constructor; by default, it
+    reproduces the hospitalization, ICU, ventilator, and fatality rates of the original model.
+    No random number is drawn for the events of probability 0, so that tables that differ only
+    by impossible events give the same random sequences.
+
+    With #m_active_index, only the infected agents of the index of each tile are visited, and
+    the agents who recovered or died are then removed from the index. Without
+    #m_event_scheduling, the immune agents who will lose their immunity stay in the index.
+
+    With #m_event_scheduling, the day of the next change of each infected or immune agent
+    (end of incubation, end of care, recovery, loss of immunity) is computed when it is
+    infected or changes, and the agent is listed in the slot of that day of the timer wheel
+    of its tile (see #EventWheel). Only the agents of the slot of the day are then visited
+    (see DiseaseState::process_event()), with the same outcomes as above.
+
+    The input argument is a MultiFab with #DiseaseParm::ncare_levels + 1 components: the number
+    of agents at each level of care (decremented at the level they leave from), and the deaths.
+    It contains the totals of these quantities for each community as the simulation progresses.
+    The events are counted in an integer buffer over the box of the grid, one for each grid and
+    thread that updates tiles of it, so that the threads do not contend for the same cells. The
+    buffers are then added to the MultiFab, which gives the same sums for any schedule of the
+    tiles.
 */
 void AgentContainer::updateStatus (MultiFab& disease_stats /*!< Community-wise disease stats tracker */)
 {
@@ -787,156 +2015,51 @@ void AgentContainer::updateStatus (MultiFab& disease_stats /*!< Community-wise d
     {
         auto& plev  = GetParticles(lev);
 
+        if (m_active_index) { updateActiveIndex(lev); }
+        if (m_event_scheduling) { updateEventWheels(lev); }
+        auto tiles = tileSchedule(lev, TilePhase::update_status);
+        const int num_tiles = static_cast<int>(tiles.size());
+        auto& tile_cost = m_tile_cost[TilePhase::update_status][lev];
+        const double phase_start = amrex::second();
+        DiseaseEvents events(disease_stats.nComp());
+        Gpu::DeviceVector<int> tile_deltas(m_incremental_totals ? 5*num_tiles : 0, 0);
+        auto tile_deltas_ptr = tile_deltas.dataPtr();
+
+        TileLoopSchedule loop_schedule{m_dynamic_tiles};
 #ifdef AMREX_USE_OMP
-#pragma omp parallel if (Gpu::notInLaunchRegion())
+#pragma omp parallel for schedule(runtime) if (Gpu::notInLaunchRegion())
 #endif
-        for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+        for (int it = 0; it < num_tiles; ++it)
         {
-            int gid = mfi.index();
-            int tid = mfi.LocalTileIndex();
+            TileTimer timer{tile_cost[tiles[it].index], m_thread_busy[TilePhase::update_status]};
+            int gid = tiles[it].grid;
+            int tid = tiles[it].tile;
             auto& ptile = plev[std::make_pair(gid, tid)];
-            auto& soa   = ptile.GetStructOfArrays();
             const auto np = ptile.numParticles();
-            auto status_ptr = soa.GetIntData(IntIdx::status).data();
-            auto age_group_ptr = soa.GetIntData(IntIdx::age_group).data();
-            auto home_i_ptr = soa.GetIntData(IntIdx::home_i).data();
-            auto home_j_ptr = soa.GetIntData(IntIdx::home_j).data();
-            auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
-            auto timer_ptr = soa.GetRealData(RealIdx::treatment_timer).data();
-            auto prob_ptr = soa.GetRealData(RealIdx::prob).data();
-            auto incubation_period_ptr = soa.GetRealData(RealIdx::incubation_period).data();
-            auto infectious_period_ptr = soa.GetRealData(RealIdx::infectious_period).data();
-
-            auto ds_arr = disease_stats[mfi].array();
-
-            struct DiseaseStats
-            {
-                enum {
-                    hospitalization = 0,
-                    ICU,
-                    ventilator,
-                    death
-                };
-            };
+            auto state = disease_state(ptile, Geom(lev), d_parm, m_log_prob, m_event_scheduling, m_day, m_rng_seed);
+            state.events = events.get(gid, tiles[it].box).array();
+            state.box = tiles[it].box;
+            if (m_incremental_totals) { state.status_deltas = tile_deltas_ptr + 5*it; }
 
-            // Track hospitalization, ICU, ventilator, and fatalities
-            Real CHR[] = {.0104, .0104, .070, .28, 1.0};  // sick -> hospital probabilities
-            Real CIC[] = {.24, .24, .24, .36, .35};      // hospital -> ICU probabilities
-            Real CVE[] = {.12, .12, .12, .22, .22};      // ICU -> ventilator probabilities
-            Real CVF[] = {.20, .20, .20, 0.45, 1.26};    // ventilator -> dead probilities
-            amrex::ParallelForRNG( np,
-                                   [=] AMREX_GPU_DEVICE (int i, amrex::RandomEngine const& engine) noexcept
-            {
-                prob_ptr[i] = 1.0;
-                if ( status_ptr[i] == Status::never ||
-                     status_ptr[i] == Status::susceptible ) {
-                    return;
-                }
-                else if (status_ptr[i] == Status::infected) {
-                    counter_ptr[i] += 1;
-                    if (counter_ptr[i] < incubation_period_ptr[i]) {
-                        // incubation phase
-                        return;
-                    }
-                    if (counter_ptr[i] == amrex::Math::ceil(incubation_period_ptr[i])) {
-                        // decide if hospitalized
-                        Real p_hosp = CHR[age_group_ptr[i]];
-                        if (amrex::Random(engine) < p_hosp) {
-                            if ((age_group_ptr[i]) < 3) {  // age groups 0-4, 5-18, 19-29
-                                timer_ptr[i] = 3;  // Ages 0-49 hospitalized for 3.1 days
-                            }
-                            else if (age_group_ptr[i] == 4) {
-                                timer_ptr[i] = 7;  // Age 65+ hospitalized for 6.5 days
-                            }
-                            else if (amrex::Random(engine) < 0.57) {
-                                timer_ptr[i] = 3;  // Proportion of 30-64 that is under 50
-                            }
-                            else {
-                                timer_ptr[i] = 8;  // Age 50-64 hospitalized for 7.8 days
-                            }
-                            amrex::Gpu::Atomic::AddNoRet(
-                                &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                        DiseaseStats::hospitalization), 1.0_rt);
-                            if (amrex::Random(engine) < CIC[age_group_ptr[i]]) {
-                                //std::printf("putting h in icu \n");
-                                timer_ptr[i] += 10;  // move to ICU
-                                amrex::Gpu::Atomic::AddNoRet(
-                                    &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                            DiseaseStats::ICU), 1.0_rt);
-                                if (amrex::Random(engine) < CVE[age_group_ptr[i]]) {
-                                    //std::printf("putting icu on v \n");
-                                    amrex::Gpu::Atomic::AddNoRet(
-                                    &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                            DiseaseStats::ventilator), 1.0_rt);
-                                    timer_ptr[i] += 10;  // put on ventilator
-                                }
-                            }
-                        }
-                    } else {
-                        if (timer_ptr[i] > 0.0) {
-                            // do hospital things
-                            timer_ptr[i] -= 1.0;
-                            if (timer_ptr[i] == 0) {
-                                if (CVF[age_group_ptr[i]] > 2.0) {
-                                    if (amrex::Random(engine) < (CVF[age_group_ptr[i]] - 2.0)) {
-                                        amrex::Gpu::Atomic::AddNoRet(
-                                            &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                                    DiseaseStats::death), 1.0_rt);
-                                        status_ptr[i] = Status::dead;
-                                        //pstruct_ptr[i].id() = -pstruct_ptr[i].id();
-                                    }
-                                }
-                                amrex::Gpu::Atomic::AddNoRet(
-                                                             &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                                                     DiseaseStats::hospitalization), -1.0_rt);
-                                if (status_ptr[i] != Status::dead) {
-                                    status_ptr[i] = Status::immune;  // If alive, hospitalized patient recovers
-                                }
-                            }
-                            if (timer_ptr[i] == 10) {
-                                if (CVF[age_group_ptr[i]] > 1.0) {
-                                    if (amrex::Random(engine) < (CVF[age_group_ptr[i]] - 1.0)) {
-                                        amrex::Gpu::Atomic::AddNoRet(
-                                            &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                                    DiseaseStats::death), 1.0_rt);
-                                        status_ptr[i] = Status::dead;
-                                        //pstruct_ptr[i].id() = -pstruct_ptr[i].id();
-                                    }
-                                }
-                                amrex::Gpu::Atomic::AddNoRet(
-                                                             &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                                                     DiseaseStats::ICU), -1.0_rt);
-                                if (status_ptr[i] != Status::dead) {
-                                    status_ptr[i] = Status::immune;  // If alive, ICU patient recovers
-                                }
-                            }
-                            if (timer_ptr[i] == 20) {
-                                if (amrex::Random(engine) < CVF[age_group_ptr[i]]) {
-                                    amrex::Gpu::Atomic::AddNoRet(
-                                        &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                                DiseaseStats::death), 1.0_rt);
-                                    status_ptr[i] = Status::dead;
-                                    //pstruct_ptr[i].id() = -pstruct_ptr[i].id();
-                                }
-
-                                amrex::Gpu::Atomic::AddNoRet(
-                                                             &ds_arr(home_i_ptr[i], home_j_ptr[i], 0,
-                                                                     DiseaseStats::ventilator), -1.0_rt);
-                                if (status_ptr[i] != Status::dead) {
-                                    status_ptr[i] = Status::immune;  // If alive, ventilated patient recovers
-                                }
-                            }
-                        }
-                        else { // not hospitalized, recover once not infectious
-                            if (counter_ptr[i] >= (incubation_period_ptr[i] + infectious_period_ptr[i])) {
-                                status_ptr[i] = Status::immune;
-                            }
-                        }
-                    }
-                }
-            });
+            if (m_event_scheduling) {
+                process_events(m_wheels[lev][tiles[it].index], state);
+            }
+            if (m_active_index) {
+                progress_active(m_active[lev][tiles[it].index], state);
+            } else if (!m_event_scheduling) {
+                amrex::ParallelForRNG( np,
+                [=] AMREX_GPU_DEVICE (int i, amrex::RandomEngine const& engine) noexcept
+                {
+                    auto rng = state.rng(i, engine, RNGPhase::update_status);
+                    state.progress(i, rng);
+                });
+            }
         }
+        m_phase_time[TilePhase::update_status] += amrex::second() - phase_start;
+        add_disease_events(disease_stats, events);
+        if (m_incremental_totals) { add_status_deltas(m_totals, tile_deltas); }
     }
+    ++m_day;
 }
 
 /*! \brief Interaction between agents
@@ -990,8 +2113,8 @@ void AgentContainer::interactAgents ()
             auto offsets = bins.offsetsPtr();
 
             auto& soa   = ptile.GetStructOfArrays();
-            auto status_ptr = soa.GetIntData(IntIdx::status).data();
-            auto strain_ptr = soa.GetIntData(IntIdx::strain).data();
+            auto status_ptr = intAttribPtr<IntIdx::status>(soa);
+            auto strain_ptr = intAttribPtr<IntIdx::strain>(soa);
             auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
 
             amrex::ParallelForRNG( bins.numBins(),
@@ -1029,11 +2152,13 @@ void AgentContainer::interactAgents ()
             amrex::Gpu::synchronize();
         }
     }
+    resetActiveIndex();  // statuses set outside of infectAgents()
 }
 
 /*! \brief Infect agents based on their current status and the computed probability of infection.
     The infection probability is computed in AgentContainer::interactAgentsHomeWork() or
-    AgentContainer::interactAgents()
+    AgentContainer::interactAgents(); with agent.log_prob, #RealIdx::prob holds the logarithm
+    of the probability of not being infected.
 */
 void AgentContainer::infectAgents ()
 {
@@ -1043,43 +2168,129 @@ void AgentContainer::infectAgents ()
     {
         auto& plev  = GetParticles(lev);
 
+        if (m_active_index) { updateActiveIndex(lev); }
+        if (m_event_scheduling) { updateEventWheels(lev); }
+        auto tiles = tileSchedule(lev, TilePhase::infect);
+        const int num_tiles = static_cast<int>(tiles.size());
+        auto& tile_cost = m_tile_cost[TilePhase::infect][lev];
+        const double phase_start = amrex::second();
+        Gpu::DeviceVector<int> tile_deltas(m_incremental_totals ? 5*num_tiles : 0, 0);
+        auto tile_deltas_ptr = tile_deltas.dataPtr();
+
+        TileLoopSchedule loop_schedule{m_dynamic_tiles};
 #ifdef AMREX_USE_OMP
-#pragma omp parallel if (Gpu::notInLaunchRegion())
+#pragma omp parallel for schedule(runtime) if (Gpu::notInLaunchRegion())
 #endif
-        for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+        for (int it = 0; it < num_tiles; ++it)
         {
-            int gid = mfi.index();
-            int tid = mfi.LocalTileIndex();
+            TileTimer timer{tile_cost[tiles[it].index], m_thread_busy[TilePhase::infect]};
+            int gid = tiles[it].grid;
+            int tid = tiles[it].tile;
             auto& ptile = plev[std::make_pair(gid, tid)];
-            auto& soa   = ptile.GetStructOfArrays();
             const auto np = ptile.numParticles();
-            auto status_ptr = soa.GetIntData(IntIdx::status).data();
-            auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
-            auto prob_ptr = soa.GetRealData(RealIdx::prob).data();
-            auto incubation_period_ptr = soa.GetRealData(RealIdx::incubation_period).data();
-            auto infectious_period_ptr = soa.GetRealData(RealIdx::infectious_period).data();
-            auto symptomdev_period_ptr = soa.GetRealData(RealIdx::symptomdev_period).data();
+            auto state = disease_state(ptile, Geom(lev), d_parm, m_log_prob, m_event_scheduling, m_day, m_rng_seed);
+            if (m_incremental_totals) { state.status_deltas = tile_deltas_ptr + 5*it; }
 
-            auto* lparm = d_parm;
+            infect_tile(static_cast<int>(np), state,
+                        m_active_index ? &m_active[lev][tiles[it].index] : nullptr,
+                        m_event_scheduling ? &m_wheels[lev][tiles[it].index] : nullptr,
+                        m_batch_rng, [=] AMREX_GPU_DEVICE (int, amrex::RandomEngine const&) noexcept {});
+        }
+        m_phase_time[TilePhase::infect] += amrex::second() - phase_start;
+        if (m_incremental_totals) { add_status_deltas(m_totals, tile_deltas); }
+    }
+}
 
-            amrex::ParallelForRNG( np,
+/*! \brief Fused end-of-day update of the agents, returning the totals of printTotals()
+
+    Equivalent to AgentContainer::infectAgents(), AgentContainer::printTotals(), and the
+    AgentContainer::updateStatus() of the next day, but in a single pass over the disease
+    attributes of each tile instead of three: each agent is infected with the probability
+    accumulated during the day, counted, and its disease is advanced to the next day. With
+    #m_active_index, the disease of the infected agents is advanced in a second pass over the
+    index only. The counts of each tile are summed on the host.
+
+    The caller must then skip updateStatus() at the beginning of the next day, and should not
+    use this before a step that writes out the agents, which would then see their status of
+    the next day (see runAgent()).
+*/
+std::array<Long, 5> AgentContainer::dailyUpdate (MultiFab& disease_stats, /*!< Community-wise disease stats tracker */
+                                                 bool reduce /*!< sum the counts over the ranks (see printTotals()) */)
+{
+    BL_PROFILE("AgentContainer::dailyUpdate");
+
+    std::array<Long, 5> counts = {0, 0, 0, 0, 0};
+    for (int lev = 0; lev <= finestLevel(); ++lev)
+    {
+        auto& plev  = GetParticles(lev);
+
+        if (m_active_index) { updateActiveIndex(lev); }
+        if (m_event_scheduling) { updateEventWheels(lev); }
+        auto tiles = tileSchedule(lev, TilePhase::daily_update);
+        const int num_tiles = static_cast<int>(tiles.size());
+        auto& tile_cost = m_tile_cost[TilePhase::daily_update][lev];
+        const double phase_start = amrex::second();
+        DiseaseEvents events(disease_stats.nComp());
+
+        // status counts of each tile
+        Gpu::DeviceVector<int> tile_counts(5*num_tiles, 0);
+        auto tile_counts_ptr = tile_counts.dataPtr();
+        Gpu::DeviceVector<int> tile_deltas(m_incremental_totals ? 5*num_tiles : 0, 0);
+        auto tile_deltas_ptr = tile_deltas.dataPtr();
+
+        TileLoopSchedule loop_schedule{m_dynamic_tiles};
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for schedule(runtime) if (Gpu::notInLaunchRegion())
+#endif
+        for (int it = 0; it < num_tiles; ++it)
+        {
+            TileTimer timer{tile_cost[tiles[it].index], m_thread_busy[TilePhase::daily_update]};
+            int gid = tiles[it].grid;
+            int tid = tiles[it].tile;
+            auto& ptile = plev[std::make_pair(gid, tid)];
+            const auto np = ptile.numParticles();
+
+            auto state = disease_state(ptile, Geom(lev), d_parm, m_log_prob, m_event_scheduling, m_day, m_rng_seed);
+            state.events = events.get(gid, tiles[it].box).array();
+            state.box = tiles[it].box;
+            if (m_incremental_totals) { state.status_deltas = tile_deltas_ptr + 5*it; }
+            int* counts_ptr = tile_counts_ptr + 5*it;
+
+            // with the index or the wheel, progress only their agents after the pass over all the agents
+            auto* index = m_active_index ? &m_active[lev][tiles[it].index] : nullptr;
+            auto* wheel = m_event_scheduling ? &m_wheels[lev][tiles[it].index] : nullptr;
+            const bool progress_all = (index == nullptr) && (wheel == nullptr);
+            infect_tile(static_cast<int>(np), state, index, wheel, m_batch_rng,
             [=] AMREX_GPU_DEVICE (int i, amrex::RandomEngine const& engine) noexcept
             {
-                prob_ptr[i] = 1.0 - prob_ptr[i];
-                if ( status_ptr[i] == Status::never ||
-                     status_ptr[i] == Status::susceptible ) {
-                    if (amrex::Random(engine) < prob_ptr[i]) {
-                        status_ptr[i] = Status::infected;
-                        counter_ptr[i] = 0.0;
-                        incubation_period_ptr[i] = amrex::RandomNormal(lparm->incubation_length_mean, lparm->incubation_length_std, engine);
-                        infectious_period_ptr[i] = amrex::RandomNormal(lparm->infectious_length_mean, lparm->infectious_length_std, engine);
-                        symptomdev_period_ptr[i] = amrex::RandomNormal(lparm->symptomdev_length_mean, lparm->symptomdev_length_std, engine);
-                        return;
-                    }
+                const int status = state.status[i];
+                AMREX_ASSERT((status >= 0) && (status <= 4));
+                amrex::Gpu::Atomic::AddNoRet(&counts_ptr[status], 1);
+                if (progress_all) {
+                    auto rng = state.rng(i, engine, RNGPhase::update_status);
+                    state.progress(i, rng);
                 }
             });
+            if (wheel != nullptr) { process_events(*wheel, state); }
+            if (index != nullptr) { progress_active(*index, state); }
+        }
+        m_phase_time[TilePhase::daily_update] += amrex::second() - phase_start;
+        add_disease_events(disease_stats, events);
+        if (m_incremental_totals) { add_status_deltas(m_totals, tile_deltas); }
+
+        Vector<int> h_tile_counts(5*num_tiles);
+        Gpu::copy(Gpu::deviceToHost, tile_counts.begin(), tile_counts.end(), h_tile_counts.begin());
+        for (int it = 0; it < num_tiles; ++it) {
+            for (int k = 0; k < 5; ++k) { counts[k] += h_tile_counts[5*it + k]; }
         }
     }
+
+    ++m_day;
+
+    if (reduce) {
+        ParallelDescriptor::ReduceLongSum(&counts[0], 5, ParallelDescriptor::IOProcessorNumber());
+    }
+    return counts;
 }
 
 /*! \brief Interaction between agents at home and workplace
@@ -1130,178 +2341,191 @@ void AgentContainer::infectAgents ()
       + If B is a child, and A is an adult, use #DiseaseParm::xmit_sch_c2a
       + If A is a child, and B is an adult, use #DiseaseParm::xmit_sch_a2c
 */
-void AgentContainer::interactAgentsHomeWork ( MultiFab& /*mask_behavior*/ /*!< Masking behavior */,
+void AgentContainer::interactAgentsHomeWork ( MultiFab& mask_behavior /*!< Masking behavior */,
                                               bool home /*!< At home (true) or at work (false) */ )
 {
     BL_PROFILE("AgentContainer::interactAgentsHomeWork");
 
+    if (m_interaction_engine == InteractionEngine::Aggregated) {
+        interactAgentsHomeWorkAggregated(mask_behavior, home);
+        return;
+    }
+
     const bool DAYTIME = !home;
-    IntVect bin_size = {AMREX_D_DECL(1, 1, 1)};
+    Long num_bins_active = 0, num_bins_total = 0;
     for (int lev = 0; lev < numLevels(); ++lev)
     {
-        const Geometry& geom = Geom(lev);
-        const auto dxi = geom.InvCellSizeArray();
-        const auto plo = geom.ProbLoArray();
-        const auto domain = geom.Domain();
+        updateBins(lev, home);
+        if (m_active_index) { updateActiveIndex(lev); }
+        auto& bins_lev = home ? m_bins_home[lev] : m_bins_work[lev];
 
-        for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
-        {
-            auto pair_ind = std::make_pair(mfi.index(), mfi.LocalTileIndex());
-            auto bins_ptr (home ? &m_bins_home[pair_ind] : &m_bins_work[pair_ind]);
-
-            auto& ptile = ParticlesAt(lev, mfi);
-            auto& aos   = ptile.GetArrayOfStructs();
-            const auto np = aos.numParticles();
-            auto pstruct_ptr = aos().dataPtr();
-
-            const Box& box = mfi.validbox();
-            int ntiles = numTilesInBox(box, true, bin_size);
-
-            auto binner = GetParticleBin{plo, dxi, domain, bin_size, box};
-            if (bins_ptr->numBins() < 0) {
-                bins_ptr->build(BinPolicy::Serial, np, pstruct_ptr, ntiles, binner);
-            }
-            AMREX_ALWAYS_ASSERT(np == bins_ptr->numItems());
-            amrex::Gpu::synchronize();
-        }
+        const int phase = home ? TilePhase::interact_home : TilePhase::interact_work;
+        auto tiles = tileSchedule(lev, phase);
+        const int num_tiles = static_cast<int>(tiles.size());
+        auto& tile_cost = m_tile_cost[phase][lev];
+        const double phase_start = amrex::second();
 
+        TileLoopSchedule loop_schedule{m_dynamic_tiles};
 #ifdef AMREX_USE_OMP
-#pragma omp parallel if (Gpu::notInLaunchRegion())
+#pragma omp parallel for schedule(runtime) if (Gpu::notInLaunchRegion()) reduction(+:num_bins_active,num_bins_total)
 #endif
-        for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+        for (int it = 0; it < num_tiles; ++it)
         {
-            auto pair_ind = std::make_pair(mfi.index(), mfi.LocalTileIndex());
-            auto bins_ptr (home ? &m_bins_home[pair_ind] : &m_bins_work[pair_ind]);
+            TileTimer timer{tile_cost[tiles[it].index], m_thread_busy[phase]};
+            auto& tile_bins = bins_lev[tiles[it].index];
+            auto bins_ptr = &tile_bins.bins;
 
-            auto& ptile = ParticlesAt(lev, mfi);
+            auto& ptile = GetParticles(lev)[std::make_pair(tiles[it].grid, tiles[it].tile)];
             auto& aos   = ptile.GetArrayOfStructs();
             const auto np = aos.numParticles();
             auto pstruct_ptr = aos().dataPtr();
 
-            auto binner = GetParticleBin{plo, dxi, domain, bin_size, mfi.validbox()};
+            // at work, the agents who work outside the box are in its edge cells (see AgentBin),
+            // so the contacts at work depend on the decomposition, even with counter_rng
+            auto binner = agentBin(lev, ptile, tiles[it].box, home);
             AMREX_ALWAYS_ASSERT(bins_ptr->numBins() >= 0);
+            AMREX_ALWAYS_ASSERT(np == bins_ptr->numItems());
             auto inds = bins_ptr->permutationPtr();
             auto offsets = bins_ptr->offsetsPtr();
 
             auto& soa   = ptile.GetStructOfArrays();
-            auto status_ptr = soa.GetIntData(IntIdx::status).data();
-            auto age_group_ptr = soa.GetIntData(IntIdx::age_group).data();
+            auto status_ptr = intAttribPtr<IntIdx::status>(soa);
+            auto age_group_ptr = intAttribPtr<IntIdx::age_group>(soa);
 
-            //auto home_i_ptr = soa.GetIntData(IntIdx::home_i).data();
-            //auto home_j_ptr = soa.GetIntData(IntIdx::home_j).data();
-            auto work_i_ptr = soa.GetIntData(IntIdx::work_i).data();
-            //auto work_j_ptr = soa.GetIntData(IntIdx::work_j).data();
+            //auto home_i_ptr = intAttribPtr<IntIdx::home_i>(soa);
+            //auto home_j_ptr = intAttribPtr<IntIdx::home_j>(soa);
+            auto work_i_ptr = intAttribPtr<IntIdx::work_i>(soa);
+            //auto work_j_ptr = intAttribPtr<IntIdx::work_j>(soa);
 
             //auto mask_arr = mask_behavior[mfi].array();
 
-            //auto strain_ptr = soa.GetIntData(IntIdx::strain).data();
+            //auto strain_ptr = intAttribPtr<IntIdx::strain>(soa);
             //auto timer_ptr = soa.GetRealData(RealIdx::timer).data();
-            auto family_ptr = soa.GetIntData(IntIdx::family).data();
-            auto nborhood_ptr = soa.GetIntData(IntIdx::nborhood).data();
-            auto school_ptr = soa.GetIntData(IntIdx::school).data();
-            auto withdrawn_ptr = soa.GetIntData(IntIdx::withdrawn).data();
-            auto workgroup_ptr = soa.GetIntData(IntIdx::workgroup).data();
+            auto family_ptr = intAttribPtr<IntIdx::family>(soa);
+            auto nborhood_ptr = intAttribPtr<IntIdx::nborhood>(soa);
+            auto school_ptr = intAttribPtr<IntIdx::school>(soa);
+            auto withdrawn_ptr = intAttribPtr<IntIdx::withdrawn>(soa);
+            auto workgroup_ptr = intAttribPtr<IntIdx::workgroup>(soa);
             auto prob_ptr = soa.GetRealData(RealIdx::prob).data();
             auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
             auto incubation_period_ptr = soa.GetRealData(RealIdx::incubation_period).data();
             //auto symptomdev_period_ptr = soa.GetRealData(RealIdx::symptomdev_period).data();
 
-            auto* lparm = d_parm;
-            amrex::ParallelFor( bins_ptr->numItems(), [=] AMREX_GPU_DEVICE (int ii) noexcept
-            {
-                auto i = inds[ii];
-                int i_cell = binner(pstruct_ptr[i]);
-                auto cell_start = offsets[i_cell];
-                auto cell_stop  = offsets[i_cell+1];
-
-                AMREX_ALWAYS_ASSERT( (Long) i < np);
-                if (status_ptr[i] == Status::immune) { return; }
-                if (status_ptr[i] == Status::dead) { return; }
-                if (status_ptr[i] == Status::infected && counter_ptr[i] < incubation_period_ptr[i]) { return; }  // incubation stage
-                //amrex::Real i_mask = mask_arr(home_i_ptr[i], home_j_ptr[i], 0);
-                for (unsigned int jj = cell_start; jj < cell_stop; ++jj) {
-                    auto j = inds[jj];
-                    if (i == j) {continue;}
-                    AMREX_ALWAYS_ASSERT( (Long) j < np);
-                    //amrex::Real j_mask = mask_arr(home_i_ptr[j], home_j_ptr[j], 0);
-                    if (status_ptr[j] == Status::immune) {continue;}
-                    if (status_ptr[j] == Status::dead) {continue;}
-                    if (status_ptr[j] == Status::infected && counter_ptr[j] < incubation_period_ptr[j]) { continue; }  // incubation stage
-
-                    if (status_ptr[j] == Status::infected &&
-                        (status_ptr[i] != Status::infected && status_ptr[i] != Status::dead)) {
-                        if (counter_ptr[j] < incubation_period_ptr[j]) { continue; }
-                        // j can infect i
-                        amrex::Real infect = lparm->infect;
-                        infect *= lparm->vac_eff;
-                        //infect *= i_mask;
-                        //infect *= j_mask;
-
-                        amrex::Real social_scale = 1.0;  // TODO this should vary based on cell
-                        amrex::Real work_scale = 1.0;  // TODO this should vary based on cell
-
-                        amrex::ParticleReal prob = 1.0;
-                        /* Determine what connections these individuals have */
-                        if ((nborhood_ptr[i] == nborhood_ptr[j]) && (family_ptr[i] == family_ptr[j]) && (! DAYTIME)) {
-                            if (age_group_ptr[j] <= 1) {  /* Transmitter j is a child */
-                                if (school_ptr[j] < 0) { // not attending school, use _SC contacts
-                                    prob *= 1.0 - infect * lparm->xmit_child_SC[age_group_ptr[i]];
-                                } else {
-                                    prob *= 1.0 - infect * lparm->xmit_child[age_group_ptr[i]];
-                                }
-                            } else {
-                                if (school_ptr[j] < 0) {  // not attending school, use _SC contacts
-                                    prob *= 1.0 - infect * lparm->xmit_adult_SC[age_group_ptr[i]];
-                                } else {
-                                    prob *= 1.0 - infect * lparm->xmit_adult[age_group_ptr[i]];
-                                }
-                            }
-                        }
-
-                        /* check for common neighborhood cluster: */
-                        else if ((nborhood_ptr[i] == nborhood_ptr[j]) && (!withdrawn_ptr[i]) && (!withdrawn_ptr[j]) && ((family_ptr[i] / 4) == (family_ptr[j] / 4)) && (!DAYTIME)) {
-                            if (age_group_ptr[j] <= 1) {  /* Transmitter i is a child */
-                                if (school_ptr[j] < 0) { // not attending school, use _SC contacts
-                                    prob *= 1.0 - infect * lparm->xmit_nc_child_SC[age_group_ptr[i]] * social_scale;
-                                } else {
-                                    prob *= 1.0 - infect * lparm->xmit_nc_child[age_group_ptr[i]] * social_scale;
-                                }
-                            } else {
-                                if (school_ptr[j] < 0) {  // not attending school, use _SC contacts
-                                    prob *= 1.0 - infect * lparm->xmit_nc_adult_SC[age_group_ptr[i]] * social_scale;
-                                } else {
-                                    prob *= 1.0 - infect * lparm->xmit_nc_adult[age_group_ptr[i]] * social_scale;
-                                }
+            /* Only the agents in bins with at least one infectious agent can be infected */
+            const int ncells = static_cast<int>(bins_ptr->numBins());
+            int num_items = static_cast<int>(bins_ptr->numItems());
+            Gpu::DeviceVector<unsigned int> active_items_d;
+            if (m_skip_inactive_bins) {
+                Gpu::DeviceVector<int> active_size_d(ncells);
+                Gpu::DeviceVector<int> active_start_d(ncells);
+                auto active_size = active_size_d.dataPtr();
+                auto active_start = active_start_d.dataPtr();
+
+                int num_active = 0;
+                if (m_active_index) {
+                    // flag the bins of the infectious agents of the index, instead of scanning all the agents
+                    auto const& index = m_active[lev][tiles[it].index];
+                    auto active_inds = index.inds.dataPtr();
+                    amrex::ParallelFor(ncells, [=] AMREX_GPU_DEVICE (int c) noexcept { active_size[c] = 0; });
+                    amrex::ParallelFor(index.count, [=] AMREX_GPU_DEVICE (int k) noexcept
+                    {
+                        auto j = active_inds[k];
+                        if ( (status_ptr[j] == Status::infected) &&
+                             (counter_ptr[j] >= incubation_period_ptr[j]) ) { active_size[binner(j)] = 1; }
+                    });
+                    num_active = Reduce::Sum<int>(ncells,
+                        [=] AMREX_GPU_DEVICE (int c) noexcept -> int
+                        {
+                            const int active = active_size[c];
+                            active_size[c] = active ? static_cast<int>(offsets[c+1] - offsets[c]) : 0;
+                            return active;
+                        });
+                } else {
+                    num_active = Reduce::Sum<int>(ncells,
+                        [=] AMREX_GPU_DEVICE (int c) noexcept -> int
+                        {
+                            int num_infectious = 0;
+                            for (unsigned int jj = offsets[c]; jj < offsets[c+1]; ++jj) {
+                                auto j = inds[jj];
+                                if ( (status_ptr[j] == Status::infected) &&
+                                     (counter_ptr[j] >= incubation_period_ptr[j]) ) { ++num_infectious; }
                             }
-                        }
+                            active_size[c] = (num_infectious > 0) ? static_cast<int>(offsets[c+1] - offsets[c]) : 0;
+                            return (num_infectious > 0) ? 1 : 0;
+                        });
+                }
+                num_bins_active += num_active;
+                num_bins_total += ncells;
+
+                num_items = Scan::PrefixSum<int>(ncells,
+                                [=] AMREX_GPU_DEVICE (int c) -> int { return active_size[c]; },
+                                [=] AMREX_GPU_DEVICE (int c, int const& x) { active_start[c] = x; },
+                                Scan::Type::exclusive, Scan::retSum);
+
+                active_items_d.resize(num_items);
+                auto active_items = active_items_d.dataPtr();
+                amrex::ParallelFor( ncells, [=] AMREX_GPU_DEVICE (int c) noexcept
+                {
+                    for (int m = 0; m < active_size[c]; ++m) {
+                        active_items[active_start[c] + m] = offsets[c] + m;
+                    }
+                });
+                Gpu::streamSynchronize();
+            }
+            const bool skip_inactive_bins = m_skip_inactive_bins;
+            const bool log_prob = m_log_prob;
+            auto active_items = active_items_d.dataPtr();
 
-                        /* Home isolation or household quarantine? */  // TODO - be careful about withdrawn versus at home...
-                        if ( (!withdrawn_ptr[i]) && (!withdrawn_ptr[j]) ) {
+            auto* lparm = d_parm;
+            if (m_hierarchical_bins) {
+                auto& hbins = tile_bins.hbins;
+                auto nborhood_offsets = hbins.nborhood_offsets.dataPtr();
+                auto group_run = hbins.group_run.dataPtr();
+                auto group_offsets = hbins.group_offsets.dataPtr();
+                auto cluster_run = hbins.cluster_run.dataPtr();
+                auto cluster_offsets = hbins.cluster_offsets.dataPtr();
+
+                amrex::ParallelFor( num_items, [=] AMREX_GPU_DEVICE (int kk) noexcept
+                {
+                    auto ii = skip_inactive_bins ? active_items[kk] : static_cast<unsigned int>(kk);
+                    auto i = inds[ii];
+                    if ( status_ptr[i] != Status::never &&
+                         status_ptr[i] != Status::susceptible ) { return; }
+                    int i_cell = binner(pstruct_ptr[i]);
+                    int age = age_group_ptr[i];
+
+                    amrex::Real infect = lparm->infect;
+                    infect *= lparm->vac_eff;
+
+                    amrex::Real social_scale = 1.0;  // TODO this should vary based on cell
+                    amrex::Real work_scale = 1.0;  // TODO this should vary based on cell
+
+                    amrex::Real prob = 1.0;
+                    amrex::Real log_escape = 0.0;
+
+                    /* Whole community: community term (and at work, neighborhood and school terms) */
+                    if (!withdrawn_ptr[i]) {
+                        for (unsigned int jj = offsets[i_cell]; jj < offsets[i_cell+1]; ++jj) {
+                            fold_escape(prob, log_escape);
+                            auto j = inds[jj];
+                            if (status_ptr[j] != Status::infected) { continue; }
+                            if (counter_ptr[j] < incubation_period_ptr[j]) { continue; }  // incubation stage
+                            if (withdrawn_ptr[j]) { continue; }
 
-                            // school < 0 means a child normally attends school, but not today
-                            /* Should always be in the same community = same cell */
                             if (school_ptr[j] < 0) {  // not attending school, use _SC contacts
-                                prob *= 1.0 - infect * lparm->xmit_comm_SC[age_group_ptr[i]] * social_scale;
+                                prob *= 1.0 - infect * lparm->xmit_comm_SC[age] * social_scale;
                             } else {
-                                prob *= 1.0 - infect * lparm->xmit_comm[age_group_ptr[i]] * social_scale;
-                            }
-
-                            /* Workgroup transmission */
-                            if (DAYTIME && workgroup_ptr[j] && (work_i_ptr[j] >= 0)) { // transmitter j at work
-                                if ((work_i_ptr[i] >= 0) && (workgroup_ptr[i] == workgroup_ptr[j])) {  // coworker
-                                    prob *= 1.0 - infect * lparm->xmit_work * work_scale;
-                                }
+                                prob *= 1.0 - infect * lparm->xmit_comm[age] * social_scale;
                             }
+                            if (!DAYTIME) { continue; }
 
-                            /* Neighborhood? */
                             if (nborhood_ptr[i] == nborhood_ptr[j]) {
                                 if (school_ptr[j] < 0) { // not attending school, use _SC contacts
-                                    prob *= 1.0 - infect * lparm->xmit_hood_SC[age_group_ptr[i]] * social_scale;
+                                    prob *= 1.0 - infect * lparm->xmit_hood_SC[age] * social_scale;
                                 } else {
-                                    prob *= 1.0 - infect * lparm->xmit_hood[age_group_ptr[i]] * social_scale;
+                                    prob *= 1.0 - infect * lparm->xmit_hood[age] * social_scale;
                                 }
-
-                                if ((school_ptr[i] == school_ptr[j]) && DAYTIME) {
+                                if (school_ptr[i] == school_ptr[j]) {
                                     if (school_ptr[i] > 5) {
                                         /* Playgroup */
                                         prob *= 1.0 - infect * lparm->xmit_school[6] * social_scale;
@@ -1310,12 +2534,12 @@ void AgentContainer::interactAgentsHomeWork ( MultiFab& /*mask_behavior*/ /*!< M
                                         prob *= 1.0 - infect * lparm->xmit_school[5] * social_scale;
                                     }
                                 }
-                            }  /* same neighborhood */
+                            }
 
                             /* Elementary/middle/high school in common */
-                            if ((school_ptr[i] == school_ptr[j]) && DAYTIME &&
+                            if ((school_ptr[i] == school_ptr[j]) &&
                                 (school_ptr[i] > 0) && (school_ptr[i] < 5)) {
-                                if (age_group_ptr[i] <= 1) {  /* Receiver i is a child */
+                                if (age <= 1) {  /* Receiver i is a child */
                                     if (age_group_ptr[j] <= 1) {  /* Transmitter j is a child */
                                         prob *= 1.0 - infect * lparm->xmit_school[school_ptr[i]] * social_scale;
                                     } else {   // Adult teacher/staff -> child student transmission
@@ -1325,9 +2549,1057 @@ void AgentContainer::interactAgentsHomeWork ( MultiFab& /*mask_behavior*/ /*!< M
                                     prob *= 1.0 - infect * lparm->xmit_sch_c2a[school_ptr[i]] * social_scale;
                                 }
                             }
-                        }  /* within society */
-                        Gpu::Atomic::Multiply(&prob_ptr[i], prob);
+                        }
+                    }
+
+                    if (!DAYTIME) {
+                        /* Neighborhood: contiguous within the cell */
+                        if (!withdrawn_ptr[i]) {
+                            auto nstart = nborhood_offsets[4*i_cell + nborhood_ptr[i]];
+                            auto nstop  = nborhood_offsets[4*i_cell + nborhood_ptr[i] + 1];
+                            for (unsigned int jj = nstart; jj < nstop; ++jj) {
+                                fold_escape(prob, log_escape);
+                                auto j = inds[jj];
+                                if (status_ptr[j] != Status::infected) { continue; }
+                                if (counter_ptr[j] < incubation_period_ptr[j]) { continue; }  // incubation stage
+                                if (withdrawn_ptr[j]) { continue; }
+                                if (school_ptr[j] < 0) { // not attending school, use _SC contacts
+                                    prob *= 1.0 - infect * lparm->xmit_hood_SC[age] * social_scale;
+                                } else {
+                                    prob *= 1.0 - infect * lparm->xmit_hood[age] * social_scale;
+                                }
+                            }
+                        }
+
+                        /* Family and neighborhood cluster: contiguous within the neighborhood */
+                        auto crun = cluster_run[ii];
+                        for (unsigned int jj = cluster_offsets[crun]; jj < cluster_offsets[crun+1]; ++jj) {
+                            fold_escape(prob, log_escape);
+                            auto j = inds[jj];
+                            if (status_ptr[j] != Status::infected) { continue; }
+                            if (counter_ptr[j] < incubation_period_ptr[j]) { continue; }  // incubation stage
+                            if (family_ptr[i] == family_ptr[j]) {
+                                if (age_group_ptr[j] <= 1) {  /* Transmitter j is a child */
+                                    if (school_ptr[j] < 0) { // not attending school, use _SC contacts
+                                        prob *= 1.0 - infect * lparm->xmit_child_SC[age];
+                                    } else {
+                                        prob *= 1.0 - infect * lparm->xmit_child[age];
+                                    }
+                                } else {
+                                    if (school_ptr[j] < 0) {  // not attending school, use _SC contacts
+                                        prob *= 1.0 - infect * lparm->xmit_adult_SC[age];
+                                    } else {
+                                        prob *= 1.0 - infect * lparm->xmit_adult[age];
+                                    }
+                                }
+                            } else if ((!withdrawn_ptr[i]) && (!withdrawn_ptr[j])) {
+                                if (age_group_ptr[j] <= 1) {  /* Transmitter j is a child */
+                                    if (school_ptr[j] < 0) { // not attending school, use _SC contacts
+                                        prob *= 1.0 - infect * lparm->xmit_nc_child_SC[age] * social_scale;
+                                    } else {
+                                        prob *= 1.0 - infect * lparm->xmit_nc_child[age] * social_scale;
+                                    }
+                                } else {
+                                    if (school_ptr[j] < 0) {  // not attending school, use _SC contacts
+                                        prob *= 1.0 - infect * lparm->xmit_nc_adult_SC[age] * social_scale;
+                                    } else {
+                                        prob *= 1.0 - infect * lparm->xmit_nc_adult[age] * social_scale;
+                                    }
+                                }
+                            }
+                        }
+                    } else if ((!withdrawn_ptr[i]) && workgroup_ptr[i] && (work_i_ptr[i] >= 0)) {
+                        /* Workgroup: contiguous within the cell */
+                        auto grun = group_run[ii];
+                        for (unsigned int jj = group_offsets[grun]; jj < group_offsets[grun+1]; ++jj) {
+                            fold_escape(prob, log_escape);
+                            auto j = inds[jj];
+                            if (status_ptr[j] != Status::infected) { continue; }
+                            if (counter_ptr[j] < incubation_period_ptr[j]) { continue; }  // incubation stage
+                            if (withdrawn_ptr[j]) { continue; }
+                            if (work_i_ptr[j] >= 0) { // transmitter j at work
+                                prob *= 1.0 - infect * lparm->xmit_work * work_scale;
+                            }
+                        }
+                    }
+
+                    if (log_prob) {
+                        prob_ptr[i] += static_cast<amrex::ParticleReal>(log_escape + std::log(prob));
+                    } else {
+                        prob_ptr[i] *= static_cast<amrex::ParticleReal>(prob * std::exp(log_escape));
+                    }
+                });
+                amrex::Gpu::synchronize();
+                continue;
+            }
+
+            const AgentAttribs attribs{status_ptr, age_group_ptr, family_ptr, nborhood_ptr, school_ptr,
+                                       withdrawn_ptr, workgroup_ptr, work_i_ptr,
+                                       counter_ptr, incubation_period_ptr};
+#ifndef AMREX_USE_GPU
+            if (m_simd_kernel) {
+                if (DAYTIME) {
+                    interact_pairwise_simd<true>(inds, offsets, ncells, attribs, lparm, prob_ptr, log_prob);
+                } else {
+                    interact_pairwise_simd<false>(inds, offsets, ncells, attribs, lparm, prob_ptr, log_prob);
+                }
+                continue;
+            }
+#endif
+            if (DAYTIME) {
+                amrex::ParallelFor( num_items, [=] AMREX_GPU_DEVICE (int kk) noexcept
+                {
+                    auto ii = skip_inactive_bins ? active_items[kk] : static_cast<unsigned int>(kk);
+                    auto i = inds[ii];
+                    int i_cell = binner(pstruct_ptr[i]);
+                    AMREX_ALWAYS_ASSERT( (Long) i < np);
+                    interact_pairwise<true>(i, inds, offsets[i_cell], offsets[i_cell+1],
+                                            attribs, lparm, prob_ptr, log_prob);
+                });
+            } else {
+                amrex::ParallelFor( num_items, [=] AMREX_GPU_DEVICE (int kk) noexcept
+                {
+                    auto ii = skip_inactive_bins ? active_items[kk] : static_cast<unsigned int>(kk);
+                    auto i = inds[ii];
+                    int i_cell = binner(pstruct_ptr[i]);
+                    AMREX_ALWAYS_ASSERT( (Long) i < np);
+                    interact_pairwise<false>(i, inds, offsets[i_cell], offsets[i_cell+1],
+                                             attribs, lparm, prob_ptr, log_prob);
+                });
+            }
+            amrex::Gpu::synchronize();
+        }
+        m_phase_time[phase] += amrex::second() - phase_start;
+    }
+
+    if (m_skip_inactive_bins && m_print_active_bins) {
+        Long counts[2] = {num_bins_active, num_bins_total};
+        ParallelDescriptor::ReduceLongSum(&counts[0], 2, ParallelDescriptor::IOProcessorNumber());
+        amrex::Print() << "    Active bins (" << (home ? "home" : "work") << "): "
+                       << counts[0] << " / " << counts[1] << " ("
+                       << ((counts[1] > 0) ? 100.0*static_cast<double>(counts[0])/static_cast<double>(counts[1]) : 0.0)
+                       << "%)\n";
+    }
+}
+
+/*! \brief Tiles of a level, in the order they are handed out to the OpenMP threads
+
+    With agent.dynamic_tile_scheduling, the tiles are sorted by decreasing cost - the time
+    spent on them the last time this phase was run, or their number of agents if it has not
+    run yet - and are handed out with a dynamic OpenMP schedule, so that each thread takes
+    the most expensive remaining tile when it becomes idle. Otherwise, the tiles are in the
+    amrex::MFIter order with a static schedule.
+
+    The tile loops using this schedule must be declared with schedule(runtime) in the scope of
+    a #TileLoopSchedule, which sets the run-time schedule of the process for the loop only, and
+    use #TileTimer to record the cost of each tile and the busy time of each thread (see
+    AgentContainer::printThreadBalance()).
+*/
+Vector<TileWork> AgentContainer::tileSchedule (int lev,   /*!< Level */
+                                               int phase  /*!< Phase of the day (#TilePhase) */)
+{
+    auto& cost = m_tile_cost[phase];
+    if (static_cast<int>(cost.size()) <= lev) { cost.resize(lev+1); }
+
+    Vector<TileWork> tiles;
+    for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        if (static_cast<int>(cost[lev].size()) < mfi.length()) {
+            cost[lev].resize(mfi.length(), -1.0_rt);
+        }
+        Real tile_cost = cost[lev][mfi.tileIndex()];
+        if (tile_cost < 0.0_rt) {
+            tile_cost = static_cast<Real>(ParticlesAt(lev, mfi).numParticles());
+        }
+        tiles.push_back(TileWork{mfi.index(), mfi.LocalTileIndex(), mfi.tileIndex(),
+                                 mfi.validbox(), tile_cost});
+    }
+
+    if (m_dynamic_tiles) {
+        std::stable_sort(tiles.begin(), tiles.end(),
+                         [] (TileWork const& a, TileWork const& b) { return a.cost > b.cost; });
+    }
+    auto& busy = m_thread_busy[phase];
+    if (static_cast<int>(busy.size()) < OpenMP::get_max_threads()) {
+        busy.resize(OpenMP::get_max_threads(), 0.0_rt);
+    }
+    return tiles;
+}
+
+/*! \brief Print the time spent by each thread in the tile loops of each phase of the day
+    (see AgentContainer::tileSchedule()) on the I/O rank, if agent.print_thread_balance is set.
+
+    For each phase, the idle time of a thread is the wall-clock time of the phase minus the
+    time the thread spent working on tiles.
+*/
+void AgentContainer::printThreadBalance () const
+{
+    if (!m_print_thread_balance) { return; }
+
+    const char* phase_names[TilePhase::nphases] = {"interaction at work", "interaction at home",
+                                                   "status update", "infection", "daily update"};
+
+    amrex::Print() << "Thread balance (" << (m_dynamic_tiles ? "dynamic" : "static")
+                   << " tile scheduling):\n";
+    for (int phase = 0; phase < TilePhase::nphases; ++phase) {
+        auto const& busy = m_thread_busy[phase];
+        if (busy.empty()) { continue; }
+
+        Real wall = m_phase_time[phase];
+        Real total_busy = 0.0;
+        for (auto b : busy) { total_busy += b; }
+        Real total = wall * static_cast<Real>(busy.size());
+
+        amrex::Print() << "    " << phase_names[phase] << ": " << wall << " s, "
+                       << ((total > 0.0_rt) ? 100.0_rt*(total - total_busy)/total : 0.0_rt)
+                       << "% idle\n";
+        for (int t = 0; t < static_cast<int>(busy.size()); ++t) {
+            amrex::Print() << "        thread " << t << ": busy " << busy[t]
+                           << " s, idle " << wall - busy[t] << " s\n";
+        }
+    }
+}
+
+/*! \brief Send a proxy of each agent that can infect or be infected at work to the rank that
+    owns its work community
+
+    With #m_proxy_work_exchange, this and AgentContainer::interactWorkProxies() replace
+    AgentContainer::moveAgentsToWork(), the work phase of AgentContainer::interactAgentsHomeWork()
+    and AgentContainer::moveAgentsToHome(). Instead of moving whole agents, which may work in a
+    box owned by another rank, only the attributes read by the work-phase kernel are packed
+    into a proxy (see #WorkExchange), for the susceptible and infectious agents. The proxies
+    are sent with non-blocking MPI, so that the home-phase interactions can run while they are
+    in flight:
+
+        pc.sendWorkProxies();
+        pc.interactAgentsHomeWork(mask_behavior, true);
+        pc.interactWorkProxies();
+
+    The agents are not moved and must not change tiles until AgentContainer::interactWorkProxies().
+*/
+void AgentContainer::sendWorkProxies ()
+{
+    BL_PROFILE("AgentContainer::sendWorkProxies");
+
+    const int lev = 0;
+    auto& wx = m_work_exchange;
+    const Box domain = Geom(lev).Domain();
+    const auto plo = Geom(lev).ProbLoArray();
+    const auto dxi = Geom(lev).InvCellSizeArray();
+    const int nprocs = ParallelDescriptor::NProcs();
+    const int myproc = ParallelDescriptor::MyProc();
+
+    if (!wx.initialized) {
+        /* owner rank of each community, and bin of each community owned by this rank */
+        const BoxArray& ba = ParticleBoxArray(lev);
+        const DistributionMapping& dm = ParticleDistributionMap(lev);
+        Vector<int> rank_of_cell(domain.numPts(), -1);
+        Vector<int> local_cell(domain.numPts(), -1);
+        int num_local_cells = 0;
+        for (int g = 0; g < static_cast<int>(ba.size()); ++g) {
+            const Box bx = ba[g];
+            for (Long n = 0; n < bx.numPts(); ++n) {
+                auto c = domain.index(bx.atOffset(n));
+                rank_of_cell[c] = dm[g];
+                if (dm[g] == myproc) { local_cell[c] = num_local_cells++; }
+            }
+        }
+        wx.rank_of_cell.resize(rank_of_cell.size());
+        Gpu::copy(Gpu::hostToDevice, rank_of_cell.begin(), rank_of_cell.end(), wx.rank_of_cell.begin());
+        wx.local_cell.resize(local_cell.size());
+        Gpu::copy(Gpu::hostToDevice, local_cell.begin(), local_cell.end(), wx.local_cell.begin());
+        wx.num_local_cells = num_local_cells;
+        wx.initialized = true;
+    }
+
+    /* Pack the proxy of each agent, and find its destination (-1: no proxy) */
+    wx.tiles.clear();
+    wx.tile_offsets.assign(1, 0);
+    for (MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        wx.tiles.push_back(std::make_pair(mfi.index(), mfi.LocalTileIndex()));
+        wx.tile_offsets.push_back(wx.tile_offsets.back() + ParticlesAt(lev, mfi).numParticles());
+    }
+    const Long nagents = wx.tile_offsets.back();
+    Gpu::DeviceVector<int> dest_d(nagents);
+    Gpu::DeviceVector<int> words_d(3*nagents);
+    for (int t = 0; t < static_cast<int>(wx.tiles.size()); ++t)
+    {
+        const Long offset = wx.tile_offsets[t];
+        const Long np = wx.tile_offsets[t+1] - offset;
+        if (np == 0) { continue; }
+        auto& ptile = GetParticles(lev)[wx.tiles[t]];
+
+        auto& soa = ptile.GetStructOfArrays();
+        auto status_ptr = intAttribPtr<IntIdx::status>(soa);
+        auto age_group_ptr = intAttribPtr<IntIdx::age_group>(soa);
+        auto nborhood_ptr = intAttribPtr<IntIdx::nborhood>(soa);
+        auto school_ptr = intAttribPtr<IntIdx::school>(soa);
+        auto withdrawn_ptr = intAttribPtr<IntIdx::withdrawn>(soa);
+        auto workgroup_ptr = intAttribPtr<IntIdx::workgroup>(soa);
+        auto work_i_ptr = intAttribPtr<IntIdx::work_i>(soa);
+        auto work_j_ptr = intAttribPtr<IntIdx::work_j>(soa);
+        auto trip_timer_ptr = intAttribPtr<IntIdx::trip_timer>(soa);
+        auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
+        auto incubation_period_ptr = soa.GetRealData(RealIdx::incubation_period).data();
+        auto rank_of_cell = wx.rank_of_cell.dataPtr();
+        auto pstruct_ptr = ptile.GetArrayOfStructs()().dataPtr();
+
+        auto dest = dest_d.dataPtr() + offset;
+        auto words = words_d.dataPtr() + 3*offset;
+        amrex::ParallelFor( np, [=] AMREX_GPU_DEVICE (Long ip) noexcept
+        {
+            const int status = status_ptr[ip];
+            const bool infectious = (status == Status::infected)
+                                    && (counter_ptr[ip] >= incubation_period_ptr[ip]);
+            const bool susceptible = (status == Status::never) || (status == Status::susceptible);
+            // agents on a trip stay in the community they are visiting, outside of any workgroup
+            const bool on_trip = (trip_timer_ptr[ip] > 0);
+            const auto c = on_trip ? domain.index(getParticleCell(pstruct_ptr[ip], plo, dxi, domain))
+                                   : domain.index(IntVect(AMREX_D_DECL(work_i_ptr[ip], work_j_ptr[ip], 0)));
+
+            int flags = ProxyField::status::set(0, status);
+            flags = ProxyField::age_group::set(flags, age_group_ptr[ip]);
+            flags = ProxyField::nborhood::set(flags, nborhood_ptr[ip]);
+            flags = ProxyField::school::set(flags, school_ptr[ip]);
+            flags = ProxyField::withdrawn::set(flags, withdrawn_ptr[ip]);
+            flags = ProxyField::infectious::set(flags, infectious);
+
+            dest[ip] = (infectious || susceptible) ? rank_of_cell[c] : -1;
+            words[3*ip] = flags;
+            words[3*ip+1] = on_trip ? 0 : workgroup_ptr[ip];
+            words[3*ip+2] = static_cast<int>(c);
+        });
+    }
+
+    /* Sort the proxies by destination rank on the device (the agents without a proxy go last),
+       and copy only the proxies to the host */
+    DenseBins<int> by_rank;
+    by_rank.build(nagents, dest_d.dataPtr(), nprocs + 1,
+                  [=] AMREX_GPU_DEVICE (int r) noexcept -> unsigned int
+                  { return static_cast<unsigned int>((r < 0) ? nprocs : r); });
+    Vector<unsigned int> rank_offsets(nprocs + 2);
+    Gpu::copy(Gpu::deviceToHost, by_rank.offsetsPtr(), by_rank.offsetsPtr() + nprocs + 2, rank_offsets.begin());
+    wx.send_counts.resize(nprocs);
+    wx.send_displs.resize(nprocs + 1);
+    for (int r = 0; r <= nprocs; ++r) { wx.send_displs[r] = static_cast<int>(rank_offsets[r]); }
+    for (int r = 0; r < nprocs; ++r) { wx.send_counts[r] = wx.send_displs[r+1] - wx.send_displs[r]; }
+
+    const int nsend = wx.send_displs[nprocs];
+    Gpu::DeviceVector<int> send_words_d(3*nsend);
+    wx.send_owner.resize(nsend);
+    auto perm = by_rank.permutationPtr();
+    auto words = words_d.dataPtr();
+    auto send_words = send_words_d.dataPtr();
+    auto send_owner = wx.send_owner.dataPtr();
+    amrex::ParallelFor( nsend, [=] AMREX_GPU_DEVICE (int n) noexcept
+    {
+        const auto k = perm[n];
+        send_words[3*n] = words[3*k];
+        send_words[3*n+1] = words[3*k+1];
+        send_words[3*n+2] = words[3*k+2];
+        send_owner[n] = static_cast<Long>(k);
+    });
+    wx.send_words.resize(3*nsend);
+    Gpu::copy(Gpu::deviceToHost, send_words_d.begin(), send_words_d.end(), wx.send_words.begin());
+
+    /* Exchange the proxies */
+    wx.recv_counts.assign(nprocs, 0);
+#ifdef AMREX_USE_MPI
+    MPI_Alltoall(wx.send_counts.data(), 1, MPI_INT, wx.recv_counts.data(), 1, MPI_INT,
+                 ParallelDescriptor::Communicator());
+#else
+    wx.recv_counts = wx.send_counts;
+#endif
+    wx.recv_displs.assign(nprocs + 1, 0);
+    for (int r = 0; r < nprocs; ++r) { wx.recv_displs[r+1] = wx.recv_displs[r] + wx.recv_counts[r]; }
+    wx.recv_words.resize(3*wx.recv_displs[nprocs]);
+
+    std::copy(wx.send_words.data() + 3*wx.send_displs[myproc], wx.send_words.data() + 3*wx.send_displs[myproc+1],
+              wx.recv_words.data() + 3*wx.recv_displs[myproc]);
+#ifdef AMREX_USE_MPI
+    const int proxy_tag = 1301;
+    wx.requests.clear();
+    for (int r = 0; r < nprocs; ++r) {
+        if ((r == myproc) || (wx.recv_counts[r] == 0)) { continue; }
+        wx.requests.emplace_back();
+        MPI_Irecv(wx.recv_words.data() + 3*wx.recv_displs[r], 3*wx.recv_counts[r], MPI_INT, r, proxy_tag,
+                  ParallelDescriptor::Communicator(), &wx.requests.back());
+    }
+    for (int r = 0; r < nprocs; ++r) {
+        if ((r == myproc) || (wx.send_counts[r] == 0)) { continue; }
+        wx.requests.emplace_back();
+        MPI_Isend(wx.send_words.data() + 3*wx.send_displs[r], 3*wx.send_counts[r], MPI_INT, r, proxy_tag,
+                  ParallelDescriptor::Communicator(), &wx.requests.back());
+    }
+#endif
+}
+
+/*! \brief Compute the work interactions of the proxies received by this rank, and return the
+    results to the owners of the agents
+
+    Completes AgentContainer::sendWorkProxies(): the proxies received are binned by work
+    community, the work-phase pairwise kernel (as in AgentContainer::interactAgentsHomeWork())
+    is applied to them, and the probability of not being infected (or its logarithm, see
+    #m_log_prob) of each proxy is returned to the rank of its agent and folded into
+    #RealIdx::prob.
+*/
+void AgentContainer::interactWorkProxies ()
+{
+    BL_PROFILE("AgentContainer::interactWorkProxies");
+
+    const int lev = 0;
+    auto& wx = m_work_exchange;
+    const int nprocs = ParallelDescriptor::NProcs();
+    const int myproc = ParallelDescriptor::MyProc();
+    const bool log_prob = m_log_prob;
+    const ParticleReal prob_init = log_prob ? 0.0_prt : 1.0_prt;
+
+#ifdef AMREX_USE_MPI
+    MPI_Waitall(static_cast<int>(wx.requests.size()), wx.requests.data(), MPI_STATUSES_IGNORE);
+#endif
+
+    /* Unpack the proxies received into contiguous attributes, and bin them by community */
+    const int nrecv = wx.recv_displs[nprocs];
+    Gpu::DeviceVector<int> words_d(3*nrecv);
+    Gpu::copy(Gpu::hostToDevice, wx.recv_words.begin(), wx.recv_words.end(), words_d.begin());
+    Gpu::DeviceVector<int> flags_d(nrecv);
+    Gpu::DeviceVector<int> workgroup_d(nrecv);
+    Gpu::DeviceVector<int> bin_d(nrecv);
+    Gpu::DeviceVector<ParticleReal> result_d(nrecv);
+    auto words = words_d.dataPtr();
+    auto flags = flags_d.dataPtr();
+    auto workgroup = workgroup_d.dataPtr();
+    auto bin = bin_d.dataPtr();
+    auto result = result_d.dataPtr();
+    auto local_cell = wx.local_cell.dataPtr();
+    amrex::ParallelFor( nrecv, [=] AMREX_GPU_DEVICE (int k) noexcept
+    {
+        flags[k] = words[3*k];
+        workgroup[k] = words[3*k+1];
+        bin[k] = local_cell[words[3*k+2]];
+        AMREX_ASSERT(bin[k] >= 0);
+        result[k] = prob_init;
+    });
+
+    DenseBins<int> bins;
+    bins.build(nrecv, bin_d.dataPtr(), wx.num_local_cells,
+               [=] AMREX_GPU_DEVICE (int b) noexcept -> unsigned int { return static_cast<unsigned int>(b); });
+    auto inds = bins.permutationPtr();
+    auto offsets = bins.offsetsPtr();
+
+    /* The work community index (bin_d) stands in for work_i: the proxies are all at work */
+    const ProxyAttribs attribs{{flags}, {flags}, {flags}, {flags}, {flags}, {flags}, workgroup, bin};
+    auto* lparm = d_parm;
+    amrex::ParallelFor( nrecv, [=] AMREX_GPU_DEVICE (int k) noexcept
+    {
+        auto c = bin[k];
+        interact_pairwise<true>(static_cast<unsigned int>(k), inds, offsets[c], offsets[c+1],
+                                attribs, lparm, result, log_prob);
+    });
+
+    /* Return the results to the ranks of the agents */
+    wx.recv_result.resize(nrecv);
+    Gpu::copy(Gpu::deviceToHost, result_d.begin(), result_d.end(), wx.recv_result.begin());
+    wx.send_result.resize(wx.send_displs[nprocs]);
+    std::copy(wx.recv_result.data() + wx.recv_displs[myproc], wx.recv_result.data() + wx.recv_displs[myproc+1],
+              wx.send_result.data() + wx.send_displs[myproc]);
+#ifdef AMREX_USE_MPI
+    const int result_tag = 1302;
+    const auto real_type = ParallelDescriptor::Mpi_typemap<ParticleReal>::type();
+    wx.requests.clear();
+    for (int r = 0; r < nprocs; ++r) {
+        if ((r == myproc) || (wx.send_counts[r] == 0)) { continue; }
+        wx.requests.emplace_back();
+        MPI_Irecv(wx.send_result.data() + wx.send_displs[r], wx.send_counts[r], real_type, r, result_tag,
+                  ParallelDescriptor::Communicator(), &wx.requests.back());
+    }
+    for (int r = 0; r < nprocs; ++r) {
+        if ((r == myproc) || (wx.recv_counts[r] == 0)) { continue; }
+        wx.requests.emplace_back();
+        MPI_Isend(wx.recv_result.data() + wx.recv_displs[r], wx.recv_counts[r], real_type, r, result_tag,
+                  ParallelDescriptor::Communicator(), &wx.requests.back());
+    }
+    MPI_Waitall(static_cast<int>(wx.requests.size()), wx.requests.data(), MPI_STATUSES_IGNORE);
+    wx.requests.clear();
+#endif
+
+    /* Fold the results into the agents */
+    const int nsend = wx.send_displs[nprocs];
+    Gpu::DeviceVector<ParticleReal> send_result_d(nsend);
+    Gpu::copy(Gpu::hostToDevice, wx.send_result.begin(), wx.send_result.end(), send_result_d.begin());
+    Gpu::DeviceVector<ParticleReal> factor_d(wx.tile_offsets.back(), prob_init);
+    auto factor = factor_d.dataPtr();
+    auto send_result = send_result_d.dataPtr();
+    auto send_owner = wx.send_owner.dataPtr();
+    amrex::ParallelFor( nsend, [=] AMREX_GPU_DEVICE (int n) noexcept
+    {
+        factor[send_owner[n]] = send_result[n];
+    });
+    for (int t = 0; t < static_cast<int>(wx.tiles.size()); ++t)
+    {
+        const Long offset = wx.tile_offsets[t];
+        const Long np = wx.tile_offsets[t+1] - offset;
+        if (np == 0) { continue; }
+        auto& ptile = GetParticles(lev)[wx.tiles[t]];
+        AMREX_ALWAYS_ASSERT(ptile.GetArrayOfStructs().numParticles() == np);
+        auto prob_ptr = ptile.GetStructOfArrays().GetRealData(RealIdx::prob).data();
+        auto factor_ptr = factor + offset;
+        amrex::ParallelFor( np, [=] AMREX_GPU_DEVICE (Long ip) noexcept
+        {
+            if (log_prob) {
+                prob_ptr[ip] += factor_ptr[ip];
+            } else {
+                prob_ptr[ip] *= factor_ptr[ip];
+            }
+        });
+        Gpu::streamSynchronize();
+    }
+}
+
+/*! \brief Make the index of the infected agents of all the tiles of a level current
+
+    The index of each tile (see #ActiveIndex) is kept up to date by infectAgents(),
+    updateStatus() and dailyUpdate(). It is only rebuilt, by a stream compaction of the agents
+    of the tile, if the tile has changed since it was built: different grid or tile, number of
+    agents, or agent storage, or if the agents may have been moved between tiles since
+    (AgentContainer::Redistribute()), or their status set elsewhere (resetActiveIndex()).
+
+    Must be called outside of an OpenMP parallel region.
+*/
+void AgentContainer::updateActiveIndex (int lev /*!< Level */)
+{
+    BL_PROFILE("AgentContainer::updateActiveIndex");
+
+    if (static_cast<int>(m_active.size()) <= lev) { m_active.resize(lev+1); }
+    auto& active_lev = m_active[lev];
+
+    for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        if (static_cast<int>(active_lev.size()) < mfi.length()) { active_lev.resize(mfi.length()); }
+        auto& index = active_lev[mfi.tileIndex()];
+
+        auto& ptile = ParticlesAt(lev, mfi);
+        const auto np = static_cast<Long>(ptile.numParticles());
+        const void* data = ptile.GetArrayOfStructs()().dataPtr();
+        if ((index.version == m_bins_version) && (index.grid == mfi.index())
+            && (index.tile == mfi.LocalTileIndex()) && (index.np == np) && (index.data == data)) {
+            continue;
+        }
+
+        // room for every agent of the tile, so that infectAgents() can append to the index
+        index.inds.resize(np);
+        auto inds = index.inds.dataPtr();
+        auto status_ptr = intAttribPtr<IntIdx::status>(ptile.GetStructOfArrays());
+        auto event_day_ptr = intAttribPtr<IntIdx::event_day>(ptile.GetStructOfArrays());
+        const bool schedule = m_event_scheduling;
+        index.count = Scan::PrefixSum<int>(static_cast<int>(np),
+            [=] AMREX_GPU_DEVICE (int i) -> int { return is_active(status_ptr[i], event_day_ptr[i], schedule) ? 1 : 0; },
+            [=] AMREX_GPU_DEVICE (int i, int const& x) {
+                if (is_active(status_ptr[i], event_day_ptr[i], schedule)) { inds[x] = i; }
+            },
+            Scan::Type::exclusive, Scan::retSum);
+        index.version = m_bins_version;
+        index.grid = mfi.index();
+        index.tile = mfi.LocalTileIndex();
+        index.np = np;
+        index.data = data;
+    }
+}
+
+/*! \brief Make the event wheels of all the tiles of a level current
+
+    The wheel of each tile (see #EventWheel) is kept up to date by infectAgents(),
+    updateStatus() and dailyUpdate(). Like the index of the infected agents (see
+    updateActiveIndex()), it is only rebuilt if the tile has changed since it was built, from
+    the day of the next event of each agent (#IntIdx::event_day). The infected agents without
+    a next event, whose status was set outside of infectAgents() (e.g. the initial cases), are
+    scheduled from their disease counter first.
+
+    Must be called outside of an OpenMP parallel region.
+*/
+void AgentContainer::updateEventWheels (int lev /*!< Level */)
+{
+    BL_PROFILE("AgentContainer::updateEventWheels");
+
+    if (static_cast<int>(m_wheels.size()) <= lev) { m_wheels.resize(lev+1); }
+    auto& wheels_lev = m_wheels[lev];
+
+    for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        if (static_cast<int>(wheels_lev.size()) < mfi.length()) { wheels_lev.resize(mfi.length()); }
+        auto& wheel = wheels_lev[mfi.tileIndex()];
+
+        auto& ptile = ParticlesAt(lev, mfi);
+        const auto np = static_cast<Long>(ptile.numParticles());
+        const void* data = ptile.GetArrayOfStructs()().dataPtr();
+        if ((wheel.version == m_bins_version) && (wheel.grid == mfi.index())
+            && (wheel.tile == mfi.LocalTileIndex()) && (wheel.np == np) && (wheel.data == data)) {
+            continue;
+        }
+
+        // the counters of the agents are those of the last status update
+        auto state = disease_state(ptile, Geom(lev), d_parm, m_log_prob, true, m_day, m_rng_seed);
+        amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (Long i) noexcept
+        {
+            const auto ii = static_cast<int>(i);
+            if ((state.status[ii] == Status::infected) && (state.event_day[ii] < 0)) {
+                state.event_day[ii] = state.next_event_day(ii, state.day - 1);
+            }
+        });
+        for (auto& slot : wheel.slots) { slot.clear(); }
+        schedule_events(wheel, nullptr, static_cast<int>(np), state.event_day);
+        wheel.version = m_bins_version;
+        wheel.grid = mfi.index();
+        wheel.tile = mfi.LocalTileIndex();
+        wheel.np = np;
+        wheel.data = data;
+    }
+}
+
+/*! \brief Bin of each agent of a tile within a box (see #AgentBin)
+
+    From the positions of the agents, or, with #m_position_free_commute, from their home or
+    work community indices, since the agents are then never moved.
+*/
+AgentBin AgentContainer::agentBin (int lev,                  /*!< Level */
+                                   ParticleTileType& ptile,  /*!< Agents of the tile */
+                                   const Box& box,           /*!< Box of the bins */
+                                   bool home                 /*!< Home (true) or work (false) bins */)
+{
+    IntVect bin_size = {AMREX_D_DECL(1, 1, 1)};
+    const Geometry& geom = Geom(lev);
+
+    AgentBin agent_bin;
+    agent_bin.binner = GetParticleBin{geom.ProbLoArray(), geom.InvCellSizeArray(), geom.Domain(), bin_size, box};
+    agent_bin.pstruct = ptile.GetArrayOfStructs()().dataPtr();
+    agent_bin.box = box;
+    if (m_position_free_commute) {
+        auto& soa = ptile.GetStructOfArrays();
+        agent_bin.ci = home ? intAttribPtr<IntIdx::home_i>(soa) : intAttribPtr<IntIdx::work_i>(soa);
+        agent_bin.cj = home ? intAttribPtr<IntIdx::home_j>(soa) : intAttribPtr<IntIdx::work_j>(soa);
+        agent_bin.trip_timer = intAttribPtr<IntIdx::trip_timer>(soa);
+    }
+    return agent_bin;
+}
+
+/*! \brief Make the cached home or work bins of all the tiles of a level current
+
+    The bins of each tile (see #TileBins) are rebuilt only if the tile has changed since they
+    were built: different grid or tile, number of agents, or agent storage, or, if the agents
+    may have been moved between tiles since (AgentContainer::Redistribute()), a different
+    fingerprint of the agent ids. AgentContainer::moveRandomTravel() marks the bins of the
+    tiles it changes as stale itself.
+
+    Must be called outside of an OpenMP parallel region, while the agents are at home (or at
+    work for the work bins).
+*/
+void AgentContainer::updateBins (int lev,   /*!< Level */
+                                 bool home  /*!< Home (true) or work (false) bins */)
+{
+    BL_PROFILE("AgentContainer::updateBins");
+
+    IntVect bin_size = {AMREX_D_DECL(1, 1, 1)};
+
+    auto& bins_store = home ? m_bins_home : m_bins_work;
+    if (static_cast<int>(bins_store.size()) <= lev) { bins_store.resize(lev+1); }
+    auto& bins_lev = bins_store[lev];
+
+    for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        if (static_cast<int>(bins_lev.size()) < mfi.length()) { bins_lev.resize(mfi.length()); }
+        auto& tile_bins = bins_lev[mfi.tileIndex()];
+
+        auto& ptile = ParticlesAt(lev, mfi);
+        auto& aos   = ptile.GetArrayOfStructs();
+        const auto np = aos.numParticles();
+        auto pstruct_ptr = aos().dataPtr();
+
+        // order-dependent fingerprint of the agent ids of this tile
+        auto fingerprint = [&] () -> unsigned long long
+        {
+            return Reduce::Sum<unsigned long long>(np,
+                [=] AMREX_GPU_DEVICE (Long i) noexcept -> unsigned long long
+                {
+                    auto key = static_cast<unsigned long long>(pstruct_ptr[i].id()) * 0x9E3779B97F4A7C15ULL
+                        + static_cast<unsigned long long>(i) * 0xC2B2AE3D27D4EB4FULL
+                        + static_cast<unsigned long long>(pstruct_ptr[i].cpu());
+                    return mixing_slot(key, 0xFFFFFFFFu);
+                });
+        };
+
+        bool stale = (tile_bins.bins.numBins() < 0)
+            || (tile_bins.grid != mfi.index()) || (tile_bins.tile != mfi.LocalTileIndex())
+            || (tile_bins.np != np) || (tile_bins.data != pstruct_ptr);
+        if (!stale && (tile_bins.version != m_bins_version)) {
+            const auto fp = fingerprint();
+            stale = (fp != tile_bins.fingerprint);
+        }
+
+        if (stale) {
+            const Box& box = mfi.validbox();
+            int ntiles = numTilesInBox(box, true, bin_size);
+            auto binner = agentBin(lev, ptile, box, home);
+            tile_bins.bins.build(BinPolicy::Serial, np, pstruct_ptr, ntiles, binner);
+            tile_bins.hbins.built = false;
+            tile_bins.grid = mfi.index();
+            tile_bins.tile = mfi.LocalTileIndex();
+            tile_bins.np = np;
+            tile_bins.data = pstruct_ptr;
+            tile_bins.fingerprint = fingerprint();
+        }
+        tile_bins.version = m_bins_version;
+        AMREX_ALWAYS_ASSERT(np == tile_bins.bins.numItems());
+
+        if (m_hierarchical_bins && !tile_bins.hbins.built) {
+            buildHierarchicalBins(tile_bins.hbins, tile_bins.bins, ptile, mfi.validbox(), lev, home);
+            tile_bins.hbins.built = true;
+        }
+        amrex::Gpu::synchronize();
+    }
+}
+
+/*! \brief Sort the agents within each bin by their mixing groups and compute the offsets
+    of each sub-level (see #HierarchicalBins)
+
+    The permutation of the given bins is sorted in place within each cell:
+    + home bins: by neighborhood, and then by family, so that each neighborhood, neighborhood
+      cluster (family/4), and family is a contiguous range of the cell;
+    + work bins: by workgroup, so that each workgroup is a contiguous range of the cell.
+
+    The agents of a group are then sorted by their random stream (see agentStream()), so that
+    the order of the contacts among the agents of a bin does not depend on the domain
+    decomposition (which agents share a bin at work still does, see AgentBin). The cell
+    offsets of the bins are not modified.
+*/
+void AgentContainer::buildHierarchicalBins (HierarchicalBins& hbins,        /*!< Sub-levels to compute */
+                                            DenseBins<ParticleType>& bins,  /*!< Cell-sorted bins of this tile */
+                                            ParticleTileType& ptile,        /*!< Agents of this tile */
+                                            const Box& box,                 /*!< Box used to compute the bins */
+                                            int lev,                        /*!< Level */
+                                            bool home                       /*!< Home (true) or work (false) bins */)
+{
+    BL_PROFILE("AgentContainer::buildHierarchicalBins");
+
+    auto binner = agentBin(lev, ptile, box, home);
+
+    const int ncells = static_cast<int>(bins.numBins());
+    const int nitems = static_cast<int>(bins.numItems());
+    auto inds = bins.permutationPtr();
+    auto offsets = bins.offsetsPtr();
+
+    auto pstruct_ptr = ptile.GetArrayOfStructs()().dataPtr();
+    auto& soa = ptile.GetStructOfArrays();
+    auto family_ptr = intAttribPtr<IntIdx::family>(soa);
+    auto nborhood_ptr = intAttribPtr<IntIdx::nborhood>(soa);
+    auto workgroup_ptr = intAttribPtr<IntIdx::workgroup>(soa);
+
+    hbins.nborhood_offsets.resize(home ? 4*ncells+1 : 0);
+    auto nborhood_offsets = hbins.nborhood_offsets.dataPtr();
+
+    // sort each cell by group, and find the neighborhood offsets; the agents of a group are
+    // sorted by their random stream, which does not depend on the domain decomposition
+    amrex::ParallelFor( ncells, [=] AMREX_GPU_DEVICE (int c) noexcept
+    {
+        auto start = offsets[c];
+        auto stop  = offsets[c+1];
+        auto stream = [=] (unsigned int i) noexcept { return agentStream(pstruct_ptr[i]); };
+        if (home) {
+            sort_by_key(inds + start, static_cast<int>(stop - start),
+                        [=] (unsigned int i) noexcept
+                        {
+                            return (static_cast<unsigned long long>(nborhood_ptr[i]) << 32)
+                                | static_cast<unsigned int>(family_ptr[i]);
+                        }, stream);
+            auto pos = start;
+            for (int n = 0; n < 4; ++n) {
+                nborhood_offsets[4*c+n] = pos;
+                while ((pos < stop) && (nborhood_ptr[inds[pos]] == n)) { ++pos; }
+            }
+            AMREX_ASSERT(pos == stop);
+            if (c == ncells-1) { nborhood_offsets[4*ncells] = stop; }
+        } else {
+            sort_by_key(inds + start, static_cast<int>(stop - start),
+                        [=] (unsigned int i) noexcept
+                        {
+                            return static_cast<unsigned int>(workgroup_ptr[i]);
+                        }, stream);
+        }
+    });
+
+    // flag the start of each run: bit 0 for a group (family or workgroup), bit 1 for a cluster
+    Gpu::DeviceVector<int> flags_d(nitems);
+    auto flags = flags_d.dataPtr();
+    amrex::ParallelFor( nitems, [=] AMREX_GPU_DEVICE (int p) noexcept
+    {
+        auto i = inds[p];
+        if ((p == 0) || (binner(pstruct_ptr[inds[p-1]]) != binner(pstruct_ptr[i]))) {
+            flags[p] = 3;
+            return;
+        }
+        auto k = inds[p-1];
+        if (home) {
+            if ((nborhood_ptr[i] != nborhood_ptr[k]) || (family_ptr[i]/4 != family_ptr[k]/4)) {
+                flags[p] = 3;
+            } else {
+                flags[p] = (family_ptr[i] != family_ptr[k]) ? 1 : 0;
+            }
+        } else {
+            flags[p] = (workgroup_ptr[i] != workgroup_ptr[k]) ? 1 : 0;
+        }
+    });
+
+    hbins.group_run.resize(nitems);
+    auto group_run = hbins.group_run.dataPtr();
+    int ngroups = Scan::PrefixSum<int>(nitems,
+                        [=] AMREX_GPU_DEVICE (int p) -> int { return flags[p] & 1; },
+                        [=] AMREX_GPU_DEVICE (int p, int const& x) { group_run[p] = x - 1; },
+                        Scan::Type::inclusive, Scan::retSum);
+
+    hbins.group_offsets.resize(ngroups+1);
+    auto group_offsets = hbins.group_offsets.dataPtr();
+    amrex::ParallelFor( nitems, [=] AMREX_GPU_DEVICE (int p) noexcept
+    {
+        if (flags[p] & 1) { group_offsets[group_run[p]] = p; }
+        if (p == nitems-1) { group_offsets[ngroups] = nitems; }
+    });
+
+    if (home) {
+        hbins.cluster_run.resize(nitems);
+        auto cluster_run = hbins.cluster_run.dataPtr();
+        int nclusters = Scan::PrefixSum<int>(nitems,
+                            [=] AMREX_GPU_DEVICE (int p) -> int { return (flags[p] >> 1) & 1; },
+                            [=] AMREX_GPU_DEVICE (int p, int const& x) { cluster_run[p] = x - 1; },
+                            Scan::Type::inclusive, Scan::retSum);
+
+        hbins.cluster_offsets.resize(nclusters+1);
+        auto cluster_offsets = hbins.cluster_offsets.dataPtr();
+        amrex::ParallelFor( nitems, [=] AMREX_GPU_DEVICE (int p) noexcept
+        {
+            if (flags[p] & 2) { cluster_offsets[cluster_run[p]] = p; }
+            if (p == nitems-1) { cluster_offsets[nclusters] = nitems; }
+        });
+    }
+    Gpu::streamSynchronize();
+}
+
+/*! \brief Interaction between agents at home and workplace using aggregated infectious pressure
+
+    Computes the same infection probabilities as the pairwise loop in
+    AgentContainer::interactAgentsHomeWork(), but in time linear in the number of agents
+    per community. Every pairwise transmission term only depends on whether the two agents
+    share a mixing group (family, neighborhood cluster, neighborhood, workgroup, school, or
+    community), on the age group of the receiver, and on the class of the transmitter
+    (child/adult, attending school or not). Thus, for each tile:
+
+    + First pass: every infectious agent adds itself to the counters of each of its mixing
+      groups (keyed by tile-local cell index and group value) for its transmitter class. The
+      counters are stored in an open-addressing hash table sized by the number of infectious
+      agents in the tile.
+    + Second pass: for every susceptible agent, look up the counters of its own mixing groups
+      and sum \f$n \log(1 - p)\f$ over each group and transmitter class, where \f$p\f$ is the
+      transmission probability of the corresponding pairwise term and \f$n\f$ is the number of
+      infectious agents in that group and class. The sum, which cannot underflow like the
+      product of the \f$(1 - p)^n\f$, is then added to (or its exponential multiplied with)
+      the probability of the agent not getting infected (RealIdx::prob).
+
+    The neighborhood-cluster term excludes members of the receiver's own family, as in the
+    pairwise loop. Selected with `agent.interaction_engine = "aggregated"`.
+*/
+void AgentContainer::interactAgentsHomeWorkAggregated ( MultiFab& /*mask_behavior*/ /*!< Masking behavior */,
+                                                        bool home /*!< At home (true) or at work (false) */ )
+{
+    BL_PROFILE("AgentContainer::interactAgentsHomeWorkAggregated");
+
+    const bool DAYTIME = !home;
+    for (int lev = 0; lev < numLevels(); ++lev)
+    {
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for(MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+        {
+            auto& ptile = ParticlesAt(lev, mfi);
+            auto& aos   = ptile.GetArrayOfStructs();
+            const auto np = aos.numParticles();
+            if (np == 0) { continue; }
+            auto pstruct_ptr = aos().dataPtr();
+
+            auto binner = agentBin(lev, ptile, mfi.validbox(), home);
+
+            auto& soa   = ptile.GetStructOfArrays();
+            auto status_ptr = intAttribPtr<IntIdx::status>(soa);
+            auto age_group_ptr = intAttribPtr<IntIdx::age_group>(soa);
+            auto work_i_ptr = intAttribPtr<IntIdx::work_i>(soa);
+            auto family_ptr = intAttribPtr<IntIdx::family>(soa);
+            auto nborhood_ptr = intAttribPtr<IntIdx::nborhood>(soa);
+            auto school_ptr = intAttribPtr<IntIdx::school>(soa);
+            auto withdrawn_ptr = intAttribPtr<IntIdx::withdrawn>(soa);
+            auto workgroup_ptr = intAttribPtr<IntIdx::workgroup>(soa);
+            auto prob_ptr = soa.GetRealData(RealIdx::prob).data();
+            auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
+            auto incubation_period_ptr = soa.GetRealData(RealIdx::incubation_period).data();
+
+            int num_infectious = Reduce::Sum<int>(np,
+                [=] AMREX_GPU_DEVICE (int i) noexcept -> int
+                {
+                    return (status_ptr[i] == Status::infected
+                            && counter_ptr[i] >= incubation_period_ptr[i]) ? 1 : 0;
+                });
+            if (num_infectious == 0) { continue; }
+
+            // each infectious agent is in at most 7 mixing groups; keep the table at most half full
+            unsigned int table_size = 16;
+            while (table_size < 14u*static_cast<unsigned int>(num_infectious)) { table_size *= 2; }
+            const unsigned int mask = table_size - 1;
+
+            Gpu::DeviceVector<unsigned long long> keys_d(table_size, empty_key);
+            Gpu::DeviceVector<int> counts_d(table_size*num_xmit_classes, 0);
+            auto keys = keys_d.dataPtr();
+            auto counts = counts_d.dataPtr();
+
+            // first pass: accumulate the infectious agents in each mixing group
+            amrex::ParallelFor( np, [=] AMREX_GPU_DEVICE (int j) noexcept
+            {
+                if (status_ptr[j] != Status::infected) { return; }
+                if (counter_ptr[j] < incubation_period_ptr[j]) { return; }  // incubation stage
+
+                auto cell = binner(pstruct_ptr[j]);
+                int cls = xmit_class(age_group_ptr[j], school_ptr[j]);
+                auto nborhood = static_cast<unsigned int>(nborhood_ptr[j]);
+                auto family = static_cast<unsigned int>(family_ptr[j]);
+                auto add = [=] (int type, unsigned int value) noexcept
+                {
+                    unsigned int slot = mixing_insert(keys, mask, mixing_key(type, cell, value));
+                    Gpu::Atomic::AddNoRet(&counts[slot*num_xmit_classes + cls], 1);
+                };
+
+                if (!DAYTIME) {
+                    add(MixingKey::family, (family << 2) | nborhood);
+                }
+                if (withdrawn_ptr[j]) { return; }
+                if (!DAYTIME) {
+                    add(MixingKey::family_nw, (family << 2) | nborhood);
+                    add(MixingKey::nc, ((family / 4) << 2) | nborhood);
+                }
+                add(MixingKey::comm, 0);
+                add(MixingKey::hood, nborhood);
+                if (DAYTIME) {
+                    if (workgroup_ptr[j] && (work_i_ptr[j] >= 0)) {
+                        add(MixingKey::work, static_cast<unsigned int>(workgroup_ptr[j]));
+                    }
+                    if (school_ptr[j] >= 5) {
+                        add(MixingKey::daycare, (static_cast<unsigned int>(school_ptr[j]) << 2) | nborhood);
+                    } else if (school_ptr[j] > 0) {
+                        add(MixingKey::school, static_cast<unsigned int>(school_ptr[j]));
+                    }
+                }
+            });
+
+            // second pass: combine the pressure of each mixing group for every susceptible agent
+            auto* lparm = d_parm;
+            const bool log_prob = m_log_prob;
+            amrex::ParallelFor( np, [=] AMREX_GPU_DEVICE (int i) noexcept
+            {
+                if ( status_ptr[i] != Status::never &&
+                     status_ptr[i] != Status::susceptible ) { return; }
+
+                auto cell = binner(pstruct_ptr[i]);
+                int age = age_group_ptr[i];
+                auto nborhood = static_cast<unsigned int>(nborhood_ptr[i]);
+                auto family = static_cast<unsigned int>(family_ptr[i]);
+
+                amrex::Real infect = lparm->infect;
+                infect *= lparm->vac_eff;
+
+                amrex::Real social_scale = 1.0;  // TODO this should vary based on cell
+                amrex::Real work_scale = 1.0;  // TODO this should vary based on cell
+
+                // number of infectious agents in a mixing group for each transmitter class
+                auto count = [=] (int type, unsigned int value, int* n) noexcept
+                {
+                    int slot = mixing_find(keys, mask, mixing_key(type, cell, value));
+                    for (int c = 0; c < num_xmit_classes; ++c) {
+                        n[c] = (slot < 0) ? 0 : counts[slot*num_xmit_classes + c];
+                    }
+                    return (slot >= 0);
+                };
+                // log of the probability of not being infected by n agents with transmission
+                // probability xmit, summed per class so that the product cannot underflow
+                auto escape = [=] (amrex::Real xmit, int n) noexcept -> amrex::Real
+                {
+                    return (n > 0) ? static_cast<amrex::Real>(n) * std::log1p(-infect * xmit)
+                                   : amrex::Real(0.0);
+                };
+
+                amrex::Real log_escape = 0.0;
+                int n[num_xmit_classes];
+                if (!DAYTIME) {
+                    /* Family */
+                    int n_fam_nw[num_xmit_classes] = {0, 0, 0, 0};
+                    if (count(MixingKey::family, (family << 2) | nborhood, n)) {
+                        log_escape += escape(lparm->xmit_child[age], n[0])
+                            + escape(lparm->xmit_child_SC[age], n[1])
+                            + escape(lparm->xmit_adult[age], n[2])
+                            + escape(lparm->xmit_adult_SC[age], n[3]);
+                        count(MixingKey::family_nw, (family << 2) | nborhood, n_fam_nw);
+                    }
+
+                    /* Neighborhood cluster, excluding the family members counted above */
+                    if (!withdrawn_ptr[i] && count(MixingKey::nc, ((family / 4) << 2) | nborhood, n)) {
+                        log_escape += escape(lparm->xmit_nc_child[age] * social_scale, n[0] - n_fam_nw[0])
+                            + escape(lparm->xmit_nc_child_SC[age] * social_scale, n[1] - n_fam_nw[1])
+                            + escape(lparm->xmit_nc_adult[age] * social_scale, n[2] - n_fam_nw[2])
+                            + escape(lparm->xmit_nc_adult_SC[age] * social_scale, n[3] - n_fam_nw[3]);
+                    }
+                }
+
+                /* Home isolation or household quarantine? */
+                if (!withdrawn_ptr[i]) {
+                    /* Community */
+                    if (count(MixingKey::comm, 0, n)) {
+                        log_escape += escape(lparm->xmit_comm[age] * social_scale, n[0] + n[2])
+                            + escape(lparm->xmit_comm_SC[age] * social_scale, n[1] + n[3]);
+                    }
+
+                    /* Neighborhood */
+                    if (count(MixingKey::hood, nborhood, n)) {
+                        log_escape += escape(lparm->xmit_hood[age] * social_scale, n[0] + n[2])
+                            + escape(lparm->xmit_hood_SC[age] * social_scale, n[1] + n[3]);
+                    }
+
+                    if (DAYTIME) {
+                        /* Workgroup */
+                        if ((work_i_ptr[i] >= 0) && workgroup_ptr[i] &&
+                            count(MixingKey::work, static_cast<unsigned int>(workgroup_ptr[i]), n)) {
+                            log_escape += escape(lparm->xmit_work * work_scale, n[0] + n[1] + n[2] + n[3]);
+                        }
+
+                        int school = school_ptr[i];
+                        if (school >= 5) {
+                            /* Day care or playgroup */
+                            if (count(MixingKey::daycare, (static_cast<unsigned int>(school) << 2) | nborhood, n)) {
+                                amrex::Real xmit = (school > 5) ? lparm->xmit_school[6] : lparm->xmit_school[5];
+                                log_escape += escape(xmit * social_scale, n[0] + n[1] + n[2] + n[3]);
+                            }
+                        } else if (school > 0) {
+                            /* Elementary/middle/high school */
+                            if (count(MixingKey::school, static_cast<unsigned int>(school), n)) {
+                                if (age <= 1) {  /* Receiver i is a child */
+                                    log_escape += escape(lparm->xmit_school[school] * social_scale, n[0] + n[1])
+                                        + escape(lparm->xmit_sch_a2c[school] * social_scale, n[2] + n[3]);
+                                } else {  // Child student -> adult teacher/staff
+                                    log_escape += escape(lparm->xmit_sch_c2a[school] * social_scale, n[0] + n[1]);
+                                }
+                            }
+                        }
                     }
+                }  /* within society */
+
+                if (log_prob) {
+                    prob_ptr[i] += static_cast<amrex::ParticleReal>(log_escape);
+                } else {
+                    prob_ptr[i] *= static_cast<amrex::ParticleReal>(std::exp(log_escape));
                 }
             });
             amrex::Gpu::synchronize();
@@ -1364,7 +3636,7 @@ void AgentContainer::generateCellData (MultiFab& mf /*!< MultiFab with at least
         [=] AMREX_GPU_DEVICE (const SuperParticleType& p,
                               amrex::Array4<amrex::Real> const& count)
         {
-            int status = p.idata(0);
+            int status = intAttrib<IntIdx::status>(p);
             auto iv = getParticleCell(p, plo, dxi, domain);
             amrex::Gpu::Atomic::AddNoRet(&count(iv, 0), 1.0_rt);
             if (status == Status::never) {
@@ -1382,28 +3654,139 @@ void AgentContainer::generateCellData (MultiFab& mf /*!< MultiFab with at least
         }, false);
 }
 
+/*! \brief Count the agents of each unit with each #Status, in a single pass over the agents
+
+    Each agent is added to the histogram of the unit of the community it is in, read from
+    \p unit_mf (the unit of each community, on the grids of the agents): the counts of this
+    rank are added to counts[5*unit + status], which the caller sets to zero. Agents in cells
+    of no unit (unit -1, past the last community in census mode) are not counted. Unlike
+    generateCellData() followed by a sum over the communities of each unit, no cell data are
+    allocated, and there is a single atomic update per agent (see ExaEpi::IO::writeFIPSData()).
+*/
+void AgentContainer::countByUnit (const iMultiFab& unit_mf,              /*!< Unit of each community */
+                                  Gpu::DeviceVector<int>& counts  /*!< Counts of each unit and status */) const
+{
+    BL_PROFILE("AgentContainer::countByUnit");
+
+    const int lev = 0;
+    const auto& geom = Geom(lev);
+    const auto plo = geom.ProbLoArray();
+    const auto dxi = geom.InvCellSizeArray();
+    const auto domain = geom.Domain();
+    const auto& plev = GetParticles(lev);
+    int* const AMREX_RESTRICT counts_ptr = counts.dataPtr();
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+    for (MFIter mfi = MakeMFIter(lev, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        auto ptile_it = plev.find(std::make_pair(mfi.index(), mfi.LocalTileIndex()));
+        if (ptile_it == plev.end()) { continue; }
+        const auto& ptile = ptile_it->second;
+        const auto* pstruct = ptile.GetArrayOfStructs()().dataPtr();
+        const int* status_ptr = ptile.GetStructOfArrays().GetIntData(IntAttrib<IntIdx::status>::comp).data();
+        const auto unit_arr = unit_mf[mfi].const_array();
+
+        amrex::ParallelFor(ptile.numParticles(), [=] AMREX_GPU_DEVICE (int i) noexcept
+        {
+            const int status = IntAttrib<IntIdx::status>::get(status_ptr[i]);
+            AMREX_ASSERT((status >= 0) && (status <= 4));
+            const int unit = unit_arr(getParticleCell(pstruct[i], plo, dxi, domain), 0);
+            // cells past the last community (census mode) belong to no unit
+            if (unit < 0) { return; }
+            // the threads of the tiles of a unit add to the same counts (omp atomic on the host)
+            amrex::HostDevice::Atomic::Add(&counts_ptr[5*unit + status], 1);
+        });
+    }
+}
+
+/*! \brief Memory allocated for the agents of this rank, in bytes
+
+    The sum over the tiles of the capacity of the particle data and of each SoA attribute, which
+    includes the spare capacity of the vectors, unlike #bytes_per_agent times the number of
+    agents.
+*/
+Long AgentContainer::agentBytes () const
+{
+    Long bytes = 0;
+    for (int lev = 0; lev < numLevels(); ++lev) {
+        for (const auto& kv : GetParticles(lev)) {
+            const auto& ptile = kv.second;
+            const auto& soa = ptile.GetStructOfArrays();
+            bytes += static_cast<Long>(ptile.GetArrayOfStructs()().capacity()*sizeof(ParticleType));
+            for (int n = 0; n < soa.NumRealComps(); ++n) {
+                bytes += static_cast<Long>(soa.GetRealData(n).capacity()*sizeof(ParticleReal));
+            }
+            for (int n = 0; n < soa.NumIntComps(); ++n) {
+                bytes += static_cast<Long>(soa.GetIntData(n).capacity()*sizeof(int));
+            }
+        }
+    }
+    return bytes;
+}
+
 /*! \brief Computes the total number of agents with each #Status
 
     Returns a vector with 5 components corresponding to each value of #Status; each element is
-    the total number of agents at a step with the corresponding #Status (in that order).
+    the total number of agents at a step with the corresponding #Status (in that order). The
+    totals are summed over the ranks on the I/O rank, unless \p reduce is false: the counts of
+    this rank are then returned, for the caller to sum without blocking (see
+    ExaEpi::Utils::AsyncReduceSum).
+
+    With #m_incremental_totals, the agents are only counted on the first call, after their
+    status was set outside of the disease kernels (see resetActiveIndex()), and every
+    #m_totals_recount_int days. In between, each rank returns its counts at the last count
+    plus the changes of status of its agents since, as counted by infectAgents(),
+    updateStatus() and dailyUpdate() (see #m_totals). These do not add up to the agents of the
+    rank, which move between ranks, but their sum over the ranks is the total. The recounts
+    check that the incremental totals match.
 */
-std::array<Long, 5> AgentContainer::printTotals () {
+std::array<Long, 5> AgentContainer::printTotals (bool reduce /*!< sum the counts over the ranks */) {
     BL_PROFILE("printTotals");
+    const bool recount = !m_totals_valid
+        || ((m_totals_recount_int > 0) && (m_day - m_totals_day >= m_totals_recount_int));
+    if (m_incremental_totals && !recount) {
+        std::array<Long, 5> counts = m_totals;
+        if (reduce) {
+            ParallelDescriptor::ReduceLongSum(&counts[0], 5, ParallelDescriptor::IOProcessorNumber());
+        }
+        return counts;
+    }
     amrex::ReduceOps<ReduceOpSum, ReduceOpSum, ReduceOpSum, ReduceOpSum, ReduceOpSum> reduce_ops;
     auto r = amrex::ParticleReduce<ReduceData<int,int,int,int,int>> (
                   *this, [=] AMREX_GPU_DEVICE (const SuperParticleType& p) noexcept
                   -> amrex::GpuTuple<int,int,int,int,int>
               {
                   int s[5] = {0, 0, 0, 0, 0};
-                  AMREX_ALWAYS_ASSERT(p.idata(IntIdx::status) >= 0);
-                  AMREX_ALWAYS_ASSERT(p.idata(IntIdx::status) <= 4);
-                  s[p.idata(IntIdx::status)] = 1;
+                  int status = intAttrib<IntIdx::status>(p);
+                  AMREX_ALWAYS_ASSERT(status >= 0);
+                  AMREX_ALWAYS_ASSERT(status <= 4);
+                  s[status] = 1;
                   return {s[0], s[1], s[2], s[3], s[4]};
               }, reduce_ops);
 
     std::array<Long, 5> counts = {amrex::get<0>(r), amrex::get<1>(r), amrex::get<2>(r), amrex::get<3>(r),
                                   amrex::get<4>(r)};
-    ParallelDescriptor::ReduceLongSum(&counts[0], 5, ParallelDescriptor::IOProcessorNumber());
+    if (m_incremental_totals) {
+        if (m_totals_valid) {
+            std::array<Long, 5> diff;
+            for (int k = 0; k < 5; ++k) { diff[k] = counts[k] - m_totals[k]; }
+            ParallelDescriptor::ReduceLongSum(&diff[0], 5, ParallelDescriptor::IOProcessorNumber());
+            if (ParallelDescriptor::IOProcessor()) {
+                for (int k = 0; k < 5; ++k) {
+                    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(diff[k] == 0,
+                        "the incremental totals of agents with each status do not match their recount");
+                }
+            }
+        }
+        m_totals = counts;
+        m_totals_valid = true;
+        m_totals_day = m_day;
+    }
+    if (reduce) {
+        ParallelDescriptor::ReduceLongSum(&counts[0], 5, ParallelDescriptor::IOProcessorNumber());
+    }
     // amrex::Print() << "Never infected: " << counts[0] << "\n";
     // amrex::Print() << "Infected: " << counts[1] << "\n";
     // amrex::Print() << "Immune: " << counts[2] << "\n";
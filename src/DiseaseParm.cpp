@@ -6,6 +6,8 @@
 
 #include "AMReX_Print.H"
 
+#include <algorithm>
+
 /*! \brief Initialize disease parameters
 
     Compute transmission probabilities for various situations based on disease
@@ -86,6 +88,55 @@ void DiseaseParm::Initialize ()
     }
 
     infect = 1.0;
+
+    // Gather the coefficients into the tables used by the interaction kernels
+    for (int i = 0; i < 5; i++) {
+        xmit_table[XmitSetting::family][XmitClass::child][i] = xmit_child[i];
+        xmit_table[XmitSetting::family][XmitClass::child_SC][i] = xmit_child_SC[i];
+        xmit_table[XmitSetting::family][XmitClass::adult][i] = xmit_adult[i];
+        xmit_table[XmitSetting::family][XmitClass::adult_SC][i] = xmit_adult_SC[i];
+
+        xmit_table[XmitSetting::nc][XmitClass::child][i] = xmit_nc_child[i];
+        xmit_table[XmitSetting::nc][XmitClass::child_SC][i] = xmit_nc_child_SC[i];
+        xmit_table[XmitSetting::nc][XmitClass::adult][i] = xmit_nc_adult[i];
+        xmit_table[XmitSetting::nc][XmitClass::adult_SC][i] = xmit_nc_adult_SC[i];
+
+        for (int c = 0; c < XmitClass::nclasses; c++) {
+            bool SC = (c == XmitClass::child_SC) || (c == XmitClass::adult_SC);
+            xmit_table[XmitSetting::comm][c][i] = SC ? xmit_comm_SC[i] : xmit_comm[i];
+            xmit_table[XmitSetting::hood][c][i] = SC ? xmit_hood_SC[i] : xmit_hood[i];
+            xmit_table[XmitSetting::work][c][i] = xmit_work;
+        }
+    }
+
+    // Timer values at the end of the stays, which must not be reached by the stays at lower levels
+    AMREX_ALWAYS_ASSERT((ncare_levels >= 1) && (ncare_levels <= max_care_levels));
+    for (int k = 0; k < ncare_levels; k++) {
+        care_exit_timer[k] = (k == 0) ? 0 : care_exit_timer[k-1] + care_extra_days[k];
+        for (int i = 0; i < 5; i++) {
+            AMREX_ALWAYS_ASSERT((care_entry_prob[k][i] >= 0.0) && (care_entry_prob[k][i] <= 1.0));
+            AMREX_ALWAYS_ASSERT((care_death_prob[k][i] >= 0.0) && (care_death_prob[k][i] <= 1.0));
+            AMREX_ALWAYS_ASSERT((care_days_short[i] > 0) && (care_days_long[i] > 0));
+            AMREX_ALWAYS_ASSERT((k == 0) || (std::max(care_days_short[i], care_days_long[i]) < care_extra_days[k]));
+        }
+    }
+
+    for (int s = 0; s < 7; s++) {
+        for (int c = 0; c < XmitClass::nclasses; c++) {
+            bool child = (c == XmitClass::child) || (c == XmitClass::child_SC);
+            for (int i = 0; i < 5; i++) {
+                if (s == 0) {
+                    xmit_school_table[s][c][i] = 0.0;
+                } else if (s >= 5) {  // daycare or playgroup
+                    xmit_school_table[s][c][i] = xmit_school[s];
+                } else if (i <= 1) {  // child receiver
+                    xmit_school_table[s][c][i] = child ? xmit_school[s] : xmit_sch_a2c[s];
+                } else {  // adult receiver
+                    xmit_school_table[s][c][i] = child ? xmit_sch_c2a[s] : 0.0;
+                }
+            }
+        }
+    }
 }
 
 void DiseaseParm::printMatrix () {
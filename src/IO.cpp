@@ -2,6 +2,7 @@
     \brief Contains IO functions in #ExaEpi::IO namespace
 */
 
+#include <AMReX_AsyncOut.H>
 #include <AMReX_GpuContainers.H>
 #include <AMReX_PlotFileUtil.H>
 #include <AMReX_REAL.H>
@@ -9,6 +10,9 @@
 
 #include "IO.H"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 using namespace amrex;
@@ -18,6 +22,77 @@ namespace ExaEpi
 namespace IO
 {
 
+namespace
+{
+    /*! \brief Names of the real attributes of the agents (#RealIdx) in the plot files */
+    const Vector<std::string> real_attrib_names = {
+        "disease_counter", "treatment_timer", "prob", "incubation_period", "infectious_period",
+        "symptomdev_period"};
+
+    /*! \brief Names of the integer attributes of the agents (#IntIdx) in the plot files; the
+        packed attributes are written as the word that packs them */
+    const Vector<std::string> int_attrib_names = {
+#ifdef EXAEPI_PACKED_ATTRIBS
+        "packed", "family", "home_i", "home_j", "work_i", "work_j", "workgroup", "work_nborhood",
+        "event_day"};
+#else
+        "status", "strain", "age_group", "family", "home_i", "home_j", "work_i", "work_j",
+        "nborhood", "school", "workgroup", "work_nborhood", "withdrawn", "symptomatic",
+        "trip_timer", "event_day"};
+#endif
+
+    /*! \brief Flags of the attributes written: all if no names are given */
+    Vector<int> attrib_flags (const Vector<std::string>& names, const std::vector<std::string>& selected)
+    {
+        Vector<int> flags(names.size(), selected.empty() ? 1 : 0);
+        for (const auto& name : selected) {
+            auto it = std::find(names.begin(), names.end(), name);
+            if (it == names.end()) { amrex::Abort("writePlotFile: unknown agent attribute " + name); }
+            flags[static_cast<int>(it - names.begin())] = 1;
+        }
+        return flags;
+    }
+
+    /*! \brief Buffers of writeFIPSData(), reused by all the calls, and freed by amrex::Finalize() */
+    struct FIPSDataBuffers
+    {
+        Gpu::DeviceVector<int> d_counts;    /*!< agents of each unit with each status */
+        Vector<int> h_counts;               /*!< host copy of #d_counts */
+    };
+
+    FIPSDataBuffers& fips_data_buffers ()
+    {
+        static std::unique_ptr<FIPSDataBuffers> buffers;
+        if (!buffers) {
+            buffers = std::make_unique<FIPSDataBuffers>();
+            amrex::ExecOnFinalize([] () { buffers.reset(); });
+        }
+        return *buffers;
+    }
+
+    /*! \brief Filter of the agents written to the plot files: the valid agents whose hash of
+        their id and cpu is a multiple of the stride, so that the same agents are written at
+        every step, whatever the decomposition */
+    struct AgentSubsample
+    {
+        std::uint64_t stride;
+
+        template <typename SrcData>
+        AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+        int operator() (const SrcData& src, int i) const noexcept
+        {
+            const auto& p = src.m_aos[i];
+            if (p.id() <= 0) { return 0; }
+            // splitmix64 finalizer
+            std::uint64_t z = agentStream(p);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= (z >> 31);
+            return (z % stride) == 0;
+        }
+    };
+}
+
 /*! \brief Write plotfile of computational domain with disease spread and census data at a given step.
 
     Writes the current disease spread information and census data (unit, FIPS code, census tract ID,
@@ -37,7 +112,12 @@ namespace IO
     + Copy unit number, FIPS code, census tract ID, and community number from the input MultiFabs to
       the remaining components.
     + Write the output MultiFab to file.
-    + Write agents to file - see AgentContainer::WritePlotFile().
+    + Write agents to file - see AgentContainer::WritePlotFile(): the attributes listed in
+      #ExaEpi::TestParams::plot_real_attribs and #ExaEpi::TestParams::plot_int_attribs, for one
+      agent in about #ExaEpi::TestParams::plot_agent_stride (see etc/read_agents.py).
+
+    With \p output, the plot file is a dump of #AsyncOutput, written in the background if
+    amrex.async_out is on.
 */
 void writePlotFile (const AgentContainer& pc,   /*!< Agent (particle) container */
                     const iMultiFab& /*num_residents*/,
@@ -45,8 +125,12 @@ void writePlotFile (const AgentContainer& pc,   /*!< Agent (particle) container
                     const iMultiFab& FIPS_mf,   /*!< MultiFab with FIPS code and census tract ID */
                     const iMultiFab& comm_mf,   /*!< MultiFab of community number */
                     const Real cur_time,        /*!< current time */
-                    const int step              /*!< Current step */) {
+                    const int step,             /*!< Current step */
+                    const TestParams& params,   /*!< Test parameters (agent output) */
+                    AsyncOutput* output         /*!< Background output, or nullptr */) {
     amrex::Print() << "Writing plotfile \n";
+    const double start = amrex::second();
+    const int dump = (output != nullptr) ? output->beginDump(amrex::Concatenate("plt", step, 5)) : -1;
 
     MultiFab output_mf(pc.ParticleBoxArray(0),
                        pc.ParticleDistributionMap(0), 9, 0);
@@ -61,8 +145,20 @@ void writePlotFile (const AgentContainer& pc,   /*!< Agent (particle) container
                              {"total", "never_infected", "infected", "immune", "susceptible", "unit", "FIPS", "Tract", "comm"},
                              pc.ParticleGeom(0), cur_time, step);
 
-    // uncomment this to write all the particles
-    pc.WritePlotFile(amrex::Concatenate("plt", step, 5), "agents");
+    static_assert(RealIdx::nattribs == 6, "real_attrib_names out of date");
+#ifdef EXAEPI_PACKED_ATTRIBS
+    static_assert(IntIdx::nattribs == 9, "int_attrib_names out of date");
+#else
+    static_assert(IntIdx::nattribs == 16, "int_attrib_names out of date");
+#endif
+    if (params.plot_agent_stride > 0) {
+        pc.WritePlotFile(amrex::Concatenate("plt", step, 5), "agents",
+                         attrib_flags(real_attrib_names, params.plot_real_attribs),
+                         attrib_flags(int_attrib_names, params.plot_int_attribs),
+                         real_attrib_names, int_attrib_names,
+                         AgentSubsample{static_cast<std::uint64_t>(params.plot_agent_stride)});
+    }
+    if (output != nullptr) { output->endDump(dump, amrex::second() - start); }
 }
 
 /*! \brief Writes diagnostic data by FIPS code
@@ -71,10 +167,15 @@ void writePlotFile (const AgentContainer& pc,   /*!< Agent (particle) container
     it writes out the number of infected agents in the same order as the units in the
     census data file.
     + Creates a output vector of size #DemographicData::Nunit (total number of units).
-    + Gets the disease status in agents from AgentContainer::generateCellData().
-    + On each processor, sets the unit-th element of the output vector to the number of
-      infected agents in the communities on this processor belonging to that unit.
+    + On each processor, counts the agents of each unit with each status in a single pass over
+      the agents (see AgentContainer::countByUnit()), in buffers reused by all the calls, and
+      sets the unit-th element of the output vector to the number of infected agents.
     + Sum across all processors and write to file.
+
+    If \p pending is given, the sum is only started, and the file is written by
+    finishFIPSData(), which the caller can delay until the reduction has progressed during the
+    next computations; the data of a previous step still pending are written first. With
+    \p output, the file is written as a dump of #AsyncOutput.
 */
 void writeFIPSData (const AgentContainer& agents, /*!< Agents (particle) container */
                     const iMultiFab& unit_mf,     /*!< MultiFab with unit number of each community */
@@ -82,52 +183,57 @@ void writeFIPSData (const AgentContainer& agents, /*!< Agents (particle) contain
                     const iMultiFab& /*comm_mf*/,
                     const DemographicData& demo,  /*!< Demographic data */
                     const std::string& prefix,    /*!< Filename prefix */
-                    const int step                /*!< Current step */) {
+                    const int step,               /*!< Current step */
+                    PendingFIPSData* pending,     /*!< Reduction to start instead of blocking, or nullptr */
+                    AsyncOutput* output           /*!< Background output, or nullptr */) {
     amrex::Print() << "Generating diagnostic data by FIPS code \n";
+    const double start = amrex::second();
 
-    std::vector<amrex::Real> data(demo.Nunit, 0.0);
-    amrex::Gpu::DeviceVector<amrex::Real> d_data(data.size(), 0.0);
-    amrex::Real* const AMREX_RESTRICT data_ptr = d_data.dataPtr();
-
-    int const nlevs = std::max(0, agents.finestLevel()+1);
-    for (int lev = 0; lev < nlevs; ++lev) {
-        MultiFab mf(agents.ParticleBoxArray(lev),
-                    agents.ParticleDistributionMap(lev), 9, 0);
-        mf.setVal(0.0);
-        agents.generateCellData(mf);
-
-#ifdef AMREX_USE_OMP
-#pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
-#endif
-        {
-            for (MFIter mfi(mf, TilingIfNotGPU()); mfi.isValid(); ++mfi)
-            {
-                auto unit_arr = unit_mf[mfi].array();
-                auto cell_data_arr = mf[mfi].array();
-
-                auto bx = mfi.tilebox();
-                amrex::ParallelFor(bx, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
-                    {
-                        int unit = unit_arr(i, j, k);  // which FIPS
-                        int num_infected = int(cell_data_arr(i, j, k, 2));
-                        amrex::Gpu::Atomic::AddNoRet(&data_ptr[unit], (amrex::Real) num_infected);
-                    });
-            }
-        }
+    PendingFIPSData blocking;
+    if (pending == nullptr) {
+        pending = &blocking;
+    } else if (pending->sum.pending) {
+        finishFIPSData(*pending, output);
     }
+    pending->filename = amrex::Concatenate(prefix, step, 5);
+
+    auto& buffers = fips_data_buffers();
+    const int ncounts = 5*demo.Nunit;
+    buffers.d_counts.resize(ncounts);
+    buffers.h_counts.resize(ncounts);
+    int* const AMREX_RESTRICT counts_ptr = buffers.d_counts.dataPtr();
+    amrex::ParallelFor(ncounts, [=] AMREX_GPU_DEVICE (int n) noexcept { counts_ptr[n] = 0; });
+    agents.countByUnit(unit_mf, buffers.d_counts);
 
     // blocking copy from device to host
     amrex::Gpu::copy(amrex::Gpu::deviceToHost,
-                     d_data.begin(), d_data.end(), data.begin());
+                     buffers.d_counts.begin(), buffers.d_counts.end(), buffers.h_counts.begin());
+
+    std::vector<amrex::Real>& data = pending->sum.data;
+    data.resize(demo.Nunit);
+    for (int unit = 0; unit < demo.Nunit; ++unit) {
+        data[unit] = static_cast<amrex::Real>(buffers.h_counts[5*unit + Status::infected]);
+    }
 
     // reduced sum over mpi ranks
-    ParallelDescriptor::ReduceRealSum
-        (data.data(), data.size(), ParallelDescriptor::IOProcessorNumber());
+    pending->sum.start();
+    pending->exposed = amrex::second() - start;
+    if (pending == &blocking) { finishFIPSData(blocking, output); }
+}
 
-    if (ParallelDescriptor::IOProcessor())
+/*! \brief Complete the sum over the ranks of the aggregated diagnostic data started by
+    writeFIPSData(), and append them to their file on the I/O rank (by the output thread of
+    \p output, if given) */
+void finishFIPSData (PendingFIPSData& pending, /*!< Data of a step being summed over the ranks */
+                     AsyncOutput* output       /*!< Background output, or nullptr */) {
+    if (!pending.sum.pending) { return; }
+    const double start = amrex::second();
+    const int dump = (output != nullptr) ? output->beginDump(pending.filename) : -1;
+    pending.sum.wait();
+
+    auto write = [data = pending.sum.data, filename = pending.filename] ()
     {
-        std::string fn = amrex::Concatenate(prefix, step, 5);
-        std::ofstream ofs{fn, std::ofstream::out | std::ofstream::app};
+        std::ofstream ofs{filename, std::ofstream::out | std::ofstream::app};
 
         // set precision
         ofs << std::fixed << std::setprecision(14) << std::scientific;
@@ -139,7 +245,96 @@ void writeFIPSData (const AgentContainer& agents, /*!< Agents (particle) contain
 
         ofs << std::endl;
         ofs.close();
+    };
+    if (ParallelDescriptor::IOProcessor())
+    {
+        if (output != nullptr) {
+            output->submit(std::move(write));
+        } else {
+            write();
+        }
+    }
+    if (output != nullptr) { output->endDump(dump, pending.exposed + amrex::second() - start); }
+}
+
+/*! \brief Output thread of amrex::AsyncOut, if amrex.async_out is on, with at most
+    \p max_dumps dumps in flight */
+AsyncOutput::AsyncOutput (int max_dumps)
+    : m_enabled(AsyncOut::UseAsyncOut()), m_max_dumps(std::max(max_dumps, 1))
+{}
+
+/*! \brief Begin a dump, once fewer than #m_max_dumps dumps are in flight; returns its index */
+int AsyncOutput::beginDump (const std::string& name /*!< name of the dump in the report */)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_written.wait(lock, [&] { return m_in_flight < m_max_dumps; });
+    ++m_in_flight;
+    m_dumps.push_back(Dump{name});
+    const int dump = static_cast<int>(m_dumps.size()) - 1;
+    lock.unlock();
+
+    if (m_enabled) {
+        AsyncOut::Submit([this, dump] ()
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_dumps[dump].start = amrex::second();
+        });
+    }
+    return dump;
+}
+
+/*! \brief Write data of the current dump on the output thread (or now if not #m_enabled);
+    \p f must own copies of the data it writes */
+void AsyncOutput::submit (std::function<void()>&& f)
+{
+    if (m_enabled) {
+        AsyncOut::Submit(std::move(f));
+    } else {
+        f();
+    }
+}
+
+/*! \brief End a dump begun by beginDump(), which took \p exposed seconds of the caller */
+void AsyncOutput::endDump (int dump, double exposed)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_dumps[dump].exposed = exposed;
+    }
+    auto written = [this, dump] ()
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_enabled) { m_dumps[dump].hidden = amrex::second() - m_dumps[dump].start; }
+        --m_in_flight;
+        m_written.notify_all();
+    };
+    if (m_enabled) {
+        // the tasks of the output thread run in order: the dump is written after this one
+        AsyncOut::Submit(std::move(written));
+    } else {
+        written();
+    }
+}
+
+/*! \brief Wait until all the dumps are written */
+void AsyncOutput::finish ()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_written.wait(lock, [&] { return m_in_flight == 0; });
+}
+
+/*! \brief Print the exposed and hidden output time of each dump (on the I/O rank) */
+void AsyncOutput::printReport () const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    double exposed = 0.0, hidden = 0.0;
+    amrex::Print() << "Output time per dump (exposed, hidden by the output thread):\n";
+    for (const auto& d : m_dumps) {
+        amrex::Print() << "    " << d.name << ": " << d.exposed << " s, " << d.hidden << " s\n";
+        exposed += d.exposed;
+        hidden += d.hidden;
     }
+    amrex::Print() << "    total: " << exposed << " s exposed, " << hidden << " s hidden\n";
 }
 
 }
@@ -140,14 +140,15 @@ namespace Initialization
     {
         auto& agents_tile = pc.GetParticles(0)[std::make_pair(mfi.index(),mfi.LocalTileIndex())];
         auto& soa = agents_tile.GetStructOfArrays();
-        auto age_group_ptr = soa.GetIntData(IntIdx::age_group).data();
-        auto home_i_ptr = soa.GetIntData(IntIdx::home_i).data();
-        auto home_j_ptr = soa.GetIntData(IntIdx::home_j).data();
-        auto work_i_ptr = soa.GetIntData(IntIdx::work_i).data();
-        auto work_j_ptr = soa.GetIntData(IntIdx::work_j).data();
-        auto nborhood_ptr = soa.GetIntData(IntIdx::nborhood).data();
-        auto workgroup_ptr = soa.GetIntData(IntIdx::workgroup).data();
-        auto work_nborhood_ptr = soa.GetIntData(IntIdx::work_nborhood).data();
+        auto pstruct = agents_tile.GetArrayOfStructs()().dataPtr();
+        auto age_group_ptr = intAttribPtr<IntIdx::age_group>(soa);
+        auto home_i_ptr = intAttribPtr<IntIdx::home_i>(soa);
+        auto home_j_ptr = intAttribPtr<IntIdx::home_j>(soa);
+        auto work_i_ptr = intAttribPtr<IntIdx::work_i>(soa);
+        auto work_j_ptr = intAttribPtr<IntIdx::work_j>(soa);
+        auto nborhood_ptr = intAttribPtr<IntIdx::nborhood>(soa);
+        auto workgroup_ptr = intAttribPtr<IntIdx::workgroup>(soa);
+        auto work_nborhood_ptr = intAttribPtr<IntIdx::work_nborhood>(soa);
         auto np = soa.numParticles();
 
         auto unit_arr = unit_mf[mfi].array();
@@ -158,11 +159,13 @@ namespace Initialization
         auto Ndaywork = demo.Ndaywork_d.data();
         auto Ncommunity = demo.Ncommunity;
         auto Nunit = demo.Nunit;
+        const auto rng_seed = pc.rngSeed();
 
         amrex::ParallelForRNG( np,
             [=] AMREX_GPU_DEVICE (int ip, RandomEngine const& engine) noexcept
             {
                 auto from = unit_arr(home_i_ptr[ip], home_j_ptr[ip], 0);
+                AgentRNG rng(engine, rng_seed, agentStream(pstruct[ip]), 0, RNGPhase::workerflow);
 
                 /* Randomly assign the eligible working-age population */
                 unsigned int number = (unsigned int) rint(((Real) Population[from]) / 2000.0);
@@ -172,7 +175,7 @@ namespace Initialization
                 int age_group = age_group_ptr[ip];
                 /* Check working-age population */
                 if ((age_group == 2) || (age_group == 3)) {
-                    unsigned int irnd = amrex::Random_int(nwork, engine);
+                    unsigned int irnd = rng.uniform_int(nwork);
                     int to = 0;
                     int comm_to = 0;
                     if (irnd < flow[from][Nunit-1]) {
@@ -182,11 +185,11 @@ namespace Initialization
                     }
 
                     /*If from=to unit, 25% EXTRA chance of working in home community*/
-                    if ((from == to) && (amrex::Random(engine) < 0.25)) {
+                    if ((from == to) && (rng.uniform() < 0.25)) {
                         comm_to = comm_arr(home_i_ptr[ip], home_j_ptr[ip], 0);
                     } else {
                         /* Choose a random community within that destination unit */
-                        comm_to = Start[to] + amrex::Random_int(Start[to+1] - Start[to], engine);
+                        comm_to = Start[to] + rng.uniform_int(Start[to+1] - Start[to]);
                         AMREX_ALWAYS_ASSERT(comm_to < Ncommunity);
                     }
 
@@ -198,10 +201,10 @@ namespace Initialization
                     number = (unsigned int) rint( ((Real) Ndaywork[to]) /
                              ((Real) WG_size * (Start[to+1] - Start[to])) );
 
-                    work_nborhood_ptr[ip]=4*(amrex::Random_int(4, engine))+nborhood_ptr[ip];
+                    work_nborhood_ptr[ip]=4*(rng.uniform_int(4))+nborhood_ptr[ip];
 
                     if (number) {
-                        workgroup_ptr[ip] = 1 + amrex::Random_int(number, engine);
+                        workgroup_ptr[ip] = 1 + rng.uniform_int(number);
                     }
                 }
             });
@@ -235,12 +238,21 @@ namespace Initialization
                                   const CaseData& /*cases*/, /*!< Case data */
                                   const DemographicData& demo, /*!< Demographic data */
                                   int unit, /*!< Unit number to infect */
-                                  int ninfect /*!< Target number of agents to infect */ ) {
+                                  int ninfect, /*!< Target number of agents to infect */
+                                  int call /*!< Number of the call, a key of the counter-based random streams */ ) {
+        const auto rng_seed = pc.rngSeed();
+
         // chose random community in unit
         int ncomms = demo.Start[unit+1] - demo.Start[unit];
         int random_comm = -1;
         if (ParallelDescriptor::IOProcessor()) {
-            random_comm = amrex::Random_int(ncomms) + demo.Start[unit];
+            if (rng_seed.enabled) {
+                // streams of the units, after those of the communities
+                AgentRNG rng(rng_seed, (std::uint64_t(1) << 63) + unit, call, RNGPhase::initial_cases);
+                random_comm = rng.uniform_int(ncomms) + demo.Start[unit];
+            } else {
+                random_comm = amrex::Random_int(ncomms) + demo.Start[unit];
+            }
         }
         ParallelDescriptor::Bcast(&random_comm, 1);
 
@@ -271,7 +283,7 @@ namespace Initialization
             auto inds = bins.permutationPtr();
             auto offsets = bins.offsetsPtr();
 
-            auto status_ptr = soa.GetIntData(IntIdx::status).data();
+            auto status_ptr = intAttribPtr<IntIdx::status>(soa);
             auto counter_ptr = soa.GetRealData(RealIdx::disease_counter).data();
             auto incubation_period_ptr = soa.GetRealData(RealIdx::incubation_period).data();
             auto infectious_period_ptr = soa.GetRealData(RealIdx::infectious_period).data();
@@ -289,6 +301,7 @@ namespace Initialization
             {
                 int community = comm_arr(i, j, k);
                 if (community != random_comm) { return; }
+                AgentRNG rng(engine, rng_seed, community, call, RNGPhase::initial_cases);
 
                 Box tbx;
                 int i_cell = getTileIndex({AMREX_D_DECL(i, j, k)}, box, true, bin_size, tbx);
@@ -304,7 +317,7 @@ namespace Initialization
                 int ni = 0;
                 /*unsigned*/ int stop = std::min(cell_start + ninfect, cell_stop);
                 for (/*unsigned*/ int ip = cell_start; ip < stop; ++ip) {
-                    int ind = cell_start + amrex::Random_int(num_this_community, engine);
+                    int ind = cell_start + rng.uniform_int(num_this_community);
                     auto pindex = inds[ind];
                     if (status_ptr[pindex] == Status::infected
                         || status_ptr[pindex] == Status::immune) {
@@ -316,9 +329,9 @@ namespace Initialization
                     } else {
                         status_ptr[pindex] = Status::infected;
                         counter_ptr[pindex] = 0;
-                        incubation_period_ptr[pindex] = amrex::RandomNormal(lparm->incubation_length_mean, lparm->incubation_length_std, engine);
-                        infectious_period_ptr[pindex] = amrex::RandomNormal(lparm->infectious_length_mean, lparm->infectious_length_std, engine);
-                        symptomdev_period_ptr[pindex] = amrex::RandomNormal(lparm->symptomdev_length_mean, lparm->symptomdev_length_std, engine);
+                        incubation_period_ptr[pindex] = static_cast<ParticleReal>(rng.normal(lparm->incubation_length_mean, lparm->incubation_length_std));
+                        infectious_period_ptr[pindex] = static_cast<ParticleReal>(rng.normal(lparm->infectious_length_mean, lparm->infectious_length_std));
+                        symptomdev_period_ptr[pindex] = static_cast<ParticleReal>(rng.normal(lparm->symptomdev_length_mean, lparm->symptomdev_length_std));
                         ++ni;
                     }
                 }
@@ -362,6 +375,7 @@ namespace Initialization
 
         int ntry = 5;
         int ninf = 0;
+        int ncalls = 0;
         for (int ihub = 0; ihub < cases.N_hubs; ++ihub) {
             if (cases.Size_hubs[ihub] > 0) {
                 int FIPS = cases.FIPS_hubs[ihub];
@@ -374,7 +388,7 @@ namespace Initialization
                     int u=0;
                     int i=0;
                     while (i < cases.Size_hubs[ihub]) {
-                        int nSuccesses= infect_random_community(pc, unit_mf, FIPS_mf, comm_mf, bin_map, cases, demo, units[u], ntry);
+                        int nSuccesses= infect_random_community(pc, unit_mf, FIPS_mf, comm_mf, bin_map, cases, demo, units[u], ntry, ncalls++);
                         ninf += nSuccesses;
                         i+= nSuccesses;
                         u=(u+1)%units.size(); //sometimes we infect fewer than ntry, but switch to next unit anyway
@@ -384,6 +398,7 @@ namespace Initialization
             }
         }
         amrex::ignore_unused(ninf);
+        pc.resetActiveIndex();
     }
 
 }
@@ -8,14 +8,18 @@
 #include <AMReX_Geometry.H>
 #include <AMReX_IntVect.H>
 #include <AMReX_ParmParse.H>
+#include <AMReX_Particle.H>
 #include <AMReX_RealBox.H>
 
 
+#include "AgentRNG.H"
 #include "DemographicData.H"
 #include "Utils.H"
 
 #include <cmath>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 using namespace amrex;
 using namespace ExaEpi;
@@ -35,6 +39,10 @@ void ExaEpi::Utils::get_test_params (   TestParams& params,         /*!< Test pa
 
     params.plot_int = -1;
     pp.query("plot_int", params.plot_int);
+    pp.queryarr("plot_real_attribs", params.plot_real_attribs);
+    pp.queryarr("plot_int_attribs", params.plot_int_attribs);
+    params.plot_agent_stride = 1;
+    pp.query("plot_agent_stride", params.plot_agent_stride);
 
     params.random_travel_int = -1;
     pp.query("random_travel_int", params.random_travel_int);
@@ -58,6 +66,17 @@ void ExaEpi::Utils::get_test_params (   TestParams& params,         /*!< Test pa
         pp.get("aggregated_diag_prefix", params.aggregated_diag_prefix);
     }
 
+    params.async_diagnostics = false;
+    pp.query("async_diagnostics", params.async_diagnostics);
+
+    params.async_output = false;
+    pp.query("async_output", params.async_output);
+    params.async_output_max_dumps = 2;
+    pp.query("async_output_max_dumps", params.async_output_max_dumps);
+
+    params.rng_benchmark = 0;
+    pp.query("rng_benchmark", params.rng_benchmark);
+
     Long seed = 0;
     bool reset_seed = pp.query("seed", seed);
     if (reset_seed) {
@@ -117,3 +136,72 @@ Geometry ExaEpi::Utils::get_geometry (const DemographicData&    demo,   /*!< dem
     geom.define(base_domain, &real_box, CoordSys::cartesian, is_per);
     return geom;
 }
+
+/*! \brief Time the counter-based random numbers of #AgentRNG on the host, and print the
+    draws per second
+
+    For \p nagents agents and a few days, the infection step draws (see
+    AgentContainer::infectAgents()) are timed:
+    + per call: 4 uniform numbers per agent, from a new AgentRNG for each agent;
+    + batched: the same numbers, from the first blocks of all the agents computed beforehand
+      by AgentRNG::fillFirstBlocks() (see AgentContainer::m_batch_rng);
+    + normal: 1 uniform and 3 normal numbers per agent (Box-Muller), as drawn for an agent
+      who gets infected.
+
+    Selected with `agent.rng_benchmark = <number of agents>`, which runs it instead of the
+    simulation.
+*/
+void ExaEpi::Utils::benchmark_rng (int nagents /*!< number of agents */)
+{
+    const int ndays = 5;
+    const CounterRNGSeed seed{true, 12345};
+    std::vector<Particle<0, 0> > agents(nagents);
+    for (int i = 0; i < nagents; ++i) {
+        agents[i].id() = i + 1;
+        agents[i].cpu() = 0;
+    }
+    std::vector<std::uint32_t> blocks(4*static_cast<std::size_t>(nagents));
+    std::vector<Real> out(nagents);
+    Real sum = 0.0;
+
+    double start = amrex::second();
+    for (int day = 0; day < ndays; ++day) {
+        for (int i = 0; i < nagents; ++i) {
+            AgentRNG rng(seed, agentStream(agents[i]), day, RNGPhase::infect);
+            out[i] = rng.uniform() + rng.uniform() + rng.uniform() + rng.uniform();
+        }
+        for (auto x : out) { sum += x; }
+    }
+    const double t_call = amrex::second() - start;
+
+    start = amrex::second();
+    for (int day = 0; day < ndays; ++day) {
+        AgentRNG::fillFirstBlocks(agents.data(), nagents, seed, day, RNGPhase::infect, blocks.data());
+        for (int i = 0; i < nagents; ++i) {
+            AgentRNG rng(seed, agentStream(agents[i]), day, RNGPhase::infect, blocks.data() + 4*static_cast<std::size_t>(i));
+            out[i] = rng.uniform() + rng.uniform() + rng.uniform() + rng.uniform();
+        }
+        for (auto x : out) { sum += x; }
+    }
+    const double t_batch = amrex::second() - start;
+
+    start = amrex::second();
+    for (int day = 0; day < ndays; ++day) {
+        for (int i = 0; i < nagents; ++i) {
+            AgentRNG rng(seed, agentStream(agents[i]), day, RNGPhase::infect);
+            out[i] = rng.uniform() + rng.normal(5.0_rt, 1.0_rt) + rng.normal(6.0_rt, 1.0_rt)
+                + rng.normal(7.0_rt, 1.0_rt);
+        }
+        for (auto x : out) { sum += x; }
+    }
+    const double t_normal = amrex::second() - start;
+
+    const double draws = 4.0*static_cast<double>(nagents)*ndays;
+    amrex::Print() << "Random number benchmark, " << nagents << " agents x " << ndays << " days (host):\n"
+                   << "    per call: " << draws/t_call/1.e6 << " Mdraws/s\n"
+                   << "    batched:  " << draws/t_batch/1.e6 << " Mdraws/s ("
+                   << t_call/t_batch << "x per call)\n"
+                   << "    1 uniform + 3 normal per agent: "
+                   << 1.e9*t_normal/(static_cast<double>(nagents)*ndays) << " ns/agent\n"
+                   << "    (checksum " << sum << ")\n";
+}
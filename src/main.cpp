@@ -14,6 +14,9 @@
 #include "IO.H"
 #include "Utils.H"
 
+#include <algorithm>
+#include <memory>
+
 using namespace amrex;
 using namespace ExaEpi;
 
@@ -27,6 +30,14 @@ void override_amrex_defaults ()
     // ExaEpi currently assumes we have mananaged memory in the Arena
     bool the_arena_is_managed = true;
     pp.queryAdd("the_arena_is_managed", the_arena_is_managed);
+
+    // background output thread for agent.async_output (see ExaEpi::IO::AsyncOutput)
+    bool async_output = false;
+    amrex::ParmParse("agent").query("async_output", async_output);
+    if (async_output) {
+        int async_out = 1;
+        pp.queryAdd("async_out", async_out);
+    }
 }
 
 /*! \brief Main function: initializes AMReX, calls runAgent(), finalizes AMReX */
@@ -80,20 +91,37 @@ int main (int argc, /*!< Number of command line arguments */
       + Let agents interact at work - see AgentContainer::interactAgentsHomeWork().
       + Move agents to home - see AgentContainer::moveAgentsToHome().
       + Let agents interact at home - see AgentContainer::interactAgentsHomeWork().
+      + Or, with `agent.proxy_work_exchange`, send proxies of the agents to the owners of
+        their work communities (AgentContainer::sendWorkProxies()), let agents interact at home,
+        and compute the work interactions of the proxies (AgentContainer::interactWorkProxies()).
       + Infect agents based on their movements during the day - see AgentContainer::infectAgents().
     + Get disease statistics counts - see AgentContainer::printTotals() - and update the
       peak number of infections and cumulative deaths.
+    + Or, with `agent.fused_daily_update`, infect the agents, count them, and update their status
+      for the next day in a single pass - see AgentContainer::dailyUpdate() - except on the last
+      day and before the days that write out the agents.
+    + With `agent.async_diagnostics`, the sums over the ranks of the disease statistics counts
+      and of the aggregated diagnostic data are started without blocking (see
+      ExaEpi::Utils::AsyncReduceSum), and completed after the interactions of the next day:
+      the counts are printed, and the peak updated, one day behind.
+    + With `agent.async_output`, the plot files and aggregated diagnostic data are written by
+      a background thread while the simulation continues (see ExaEpi::IO::AsyncOutput).
 
     \b Finalize
     + Report peak infections, day of peak infections, and cumulative deaths.
     + Write out final plot file - see ExaEpi::IO::writePlotFile()
     + Write out final aggregated diagnostic data - see ExaEpi::IO::writeFIPSData().
+    + With `agent.async_output`, wait for the output and report its time per dump.
 */
 void runAgent ()
 {
     BL_PROFILE("runAgent");
     TestParams params;
     ExaEpi::Utils::get_test_params(params, "agent");
+    if (params.rng_benchmark > 0) {
+        ExaEpi::Utils::benchmark_rng(params.rng_benchmark);
+        return;
+    }
 
     DemographicData demo;
     if (params.ic_type == ICType::Census) { demo.InitFromFile(params.census_filename); }
@@ -118,12 +146,15 @@ void runAgent ()
     iMultiFab FIPS_mf(ba, dm, 2, 0);
     iMultiFab comm_mf(ba, dm, 1, 0);
 
-    MultiFab disease_stats(ba, dm, 4, 0);
     MultiFab mask_behavior(ba, dm, 1, 0);
     mask_behavior.setVal(1);
 
     AgentContainer pc(geom, dm, ba);
 
+    // agents at each level of care and deaths, see AgentContainer::updateStatus()
+    MultiFab disease_stats(ba, dm, pc.getDiseaseParameters_h()->ncare_levels + 1, 0);
+    disease_stats.setVal(0);
+
     {
         BL_PROFILE_REGION("Initialization");
         if (params.ic_type == ICType::Demo) {
@@ -135,6 +166,17 @@ void runAgent ()
         }
     }
 
+    {
+        const Long num_agents = pc.TotalNumberOfParticles();
+        Long agent_bytes = pc.agentBytes();
+        ParallelDescriptor::ReduceLongSum(agent_bytes, ParallelDescriptor::IOProcessorNumber());
+        amrex::Print() << "Agent attributes: " << AgentContainer::bytes_per_agent << " bytes per agent, "
+                       << num_agents*AgentContainer::bytes_per_agent << " bytes in total \n"
+                       << "Agent memory allocated: " << agent_bytes << " bytes, "
+                       << static_cast<double>(agent_bytes)/static_cast<double>(std::max(num_agents, Long(1)))
+                       << " bytes per agent \n";
+    }
+
     int  step_of_peak = 0;
     Long num_infected_peak = 0;
     Long cumulative_deaths = 0;
@@ -147,49 +189,112 @@ void runAgent ()
         cumulative_deaths = counts[4];
     }
 
+    // counts of a day summed over the ranks, printed one day behind with async_diagnostics
+    auto report_totals = [&] (const std::array<Long, 5>& counts, int day) {
+        if (counts[1] > num_infected_peak) {
+            num_infected_peak = counts[1];
+            step_of_peak = day;
+        }
+        cumulative_deaths = counts[4];
+
+        if (params.async_diagnostics) {
+            amrex::Print() << "    Totals of day " << day << ":\n";
+        }
+        amrex::Print() << "    Total never: "       << counts[0] << "\n";
+        amrex::Print() << "    Total infected: "    << counts[1] << "\n";
+        amrex::Print() << "    Total immune: "      << counts[2] << "\n";
+     // amrex::Print() << "    Total susceptible: " << counts[3] << "\n";
+        amrex::Print() << "    Total deaths: "      << counts[4] << "\n";
+        amrex::Print() << "\n";
+    };
+
+    ExaEpi::Utils::AsyncReduceSum<Long> pending_totals;
+    int pending_day = -1;
+    ExaEpi::IO::PendingFIPSData pending_fips;
+    auto* fips_async = params.async_diagnostics ? &pending_fips : nullptr;
+    std::unique_ptr<ExaEpi::IO::AsyncOutput> async_output;
+    if (params.async_output) {
+        async_output = std::make_unique<ExaEpi::IO::AsyncOutput>(params.async_output_max_dumps);
+    }
+    auto* output = async_output.get();
+    auto finish_diagnostics = [&] () {
+        if (pending_totals.pending) {
+            pending_totals.wait();
+            std::array<Long, 5> counts;
+            std::copy(pending_totals.data.begin(), pending_totals.data.end(), counts.begin());
+            report_totals(counts, pending_day);
+        }
+        ExaEpi::IO::finishFIPSData(pending_fips, output);
+    };
+
     amrex::Real cur_time = 0;
     {
         BL_PROFILE_REGION("Evolution");
+        bool status_updated = false;  // by the dailyUpdate() of the previous day
         for (int i = 0; i < params.nsteps; ++i)
         {
             amrex::Print() << "Simulating day " << i << "\n";
 
             if ((params.plot_int > 0) && (i % params.plot_int == 0)) {
-                ExaEpi::IO::writePlotFile(pc, num_residents, unit_mf, FIPS_mf, comm_mf, cur_time, i);
+                ExaEpi::IO::writePlotFile(pc, num_residents, unit_mf, FIPS_mf, comm_mf, cur_time, i, params, output);
             }
 
             if ((params.aggregated_diag_int > 0) && (i % params.aggregated_diag_int == 0)) {
-                ExaEpi::IO::writeFIPSData(pc, unit_mf, FIPS_mf, comm_mf, demo, params.aggregated_diag_prefix, i);
+                ExaEpi::IO::writeFIPSData(pc, unit_mf, FIPS_mf, comm_mf, demo, params.aggregated_diag_prefix, i,
+                                          fips_async, output);
             }
 
-            pc.updateStatus(disease_stats);
-            pc.moveAgentsToWork();
-            pc.interactAgentsHomeWork(mask_behavior, false);
-            pc.moveAgentsToHome();
-            pc.interactAgentsHomeWork(mask_behavior, true);
-            pc.infectAgents();
-
-            //            if ((params.random_travel_int > 0) && (i % params.random_travel_int == 0)) {
-            //                pc.moveRandomTravel();
-            //            }
-            //            pc.Redistribute();
-
-            auto counts = pc.printTotals();
-            if (counts[1] > num_infected_peak) {
-                num_infected_peak = counts[1];
-                step_of_peak = i;
+            if (!status_updated) { pc.updateStatus(disease_stats); }
+            if (pc.proxyWorkExchange()) {
+                // the home interactions run while the work proxies are in flight
+                pc.sendWorkProxies();
+                pc.interactAgentsHomeWork(mask_behavior, true);
+                pc.interactWorkProxies();
+            } else {
+                pc.moveAgentsToWork();
+                pc.interactAgentsHomeWork(mask_behavior, false);
+                pc.moveAgentsToHome();
+                pc.interactAgentsHomeWork(mask_behavior, true);
             }
-            cumulative_deaths = counts[4];
 
-            amrex::Print() << "    Total never: "       << counts[0] << "\n";
-            amrex::Print() << "    Total infected: "    << counts[1] << "\n";
-            amrex::Print() << "    Total immune: "      << counts[2] << "\n";
-         // amrex::Print() << "    Total susceptible: " << counts[3] << "\n";
-            amrex::Print() << "    Total deaths: "      << counts[4] << "\n";
-            amrex::Print() << "\n";
+            // the reductions of the previous day had the interactions of this day to progress
+            finish_diagnostics();
+
+            // trips are counted down every step, and new ones start every random_travel_int steps
+            auto random_travel = [&] () {
+                if (params.random_travel_int > 0) {
+                    pc.moveRandomTravel(i % params.random_travel_int == 0);
+                }
+            };
+
+            // the fused update also advances the status to the next day, so it is not used
+            // on the last day or before a day that writes out the agents
+            const int next = i + 1;
+            status_updated = pc.fusedDailyUpdate() && (next < params.nsteps)
+                && !((params.plot_int > 0) && (next % params.plot_int == 0))
+                && !((params.aggregated_diag_int > 0) && (next % params.aggregated_diag_int == 0));
+
+            const bool reduce = !params.async_diagnostics;
+            std::array<Long, 5> counts;
+            if (status_updated) {
+                random_travel();  // does not depend on the infections of the day
+                counts = pc.dailyUpdate(disease_stats, reduce);
+            } else {
+                pc.infectAgents();
+                random_travel();
+                counts = pc.printTotals(reduce);
+            }
+            if (reduce) {
+                report_totals(counts, i);
+            } else {
+                pending_totals.data.assign(counts.begin(), counts.end());
+                pending_totals.start();
+                pending_day = i;
+            }
 
             cur_time += 1.0; // time step is one day
         }
+        finish_diagnostics();
     }
 
     amrex::Print() << "\n \n";
@@ -198,11 +303,19 @@ void runAgent ()
     amrex::Print() << "Cumulative deaths: " << cumulative_deaths << "\n";
     amrex::Print() << "\n \n";
 
+    pc.printThreadBalance();
+
     if (params.plot_int > 0) {
-        ExaEpi::IO::writePlotFile(pc, num_residents, unit_mf, FIPS_mf, comm_mf, cur_time, params.nsteps);
+        ExaEpi::IO::writePlotFile(pc, num_residents, unit_mf, FIPS_mf, comm_mf, cur_time, params.nsteps, params, output);
     }
 
     if ((params.aggregated_diag_int > 0) && (params.nsteps % params.aggregated_diag_int == 0)) {
-        ExaEpi::IO::writeFIPSData(pc, unit_mf, FIPS_mf, comm_mf, demo, params.aggregated_diag_prefix, params.nsteps);
+        ExaEpi::IO::writeFIPSData(pc, unit_mf, FIPS_mf, comm_mf, demo, params.aggregated_diag_prefix, params.nsteps,
+                                  nullptr, output);
+    }
+
+    if (async_output) {
+        async_output->finish();
+        async_output->printReport();
     }
 }